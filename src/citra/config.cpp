@@ -87,6 +87,12 @@ void Config::ReadValues() {
     // Renderer
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_vertex_loader_jit =
+        sdl2_config->GetBoolean("Renderer", "use_vertex_loader_jit", false);
+    Settings::values.parallel_vertex_threshold = static_cast<u32>(
+        sdl2_config->GetInteger("Renderer", "parallel_vertex_threshold", 0));
+    Settings::values.vertex_cache_size =
+        static_cast<u32>(sdl2_config->GetInteger("Renderer", "vertex_cache_size", 1024));
     Settings::values.resolution_factor =
         (float)sdl2_config->GetReal("Renderer", "resolution_factor", 1.0);
     Settings::values.use_vsync = sdl2_config->GetBoolean("Renderer", "use_vsync", false);
@@ -128,6 +134,8 @@ void Config::ReadValues() {
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.cache_file_writes =
+        sdl2_config->GetBoolean("Data Storage", "cache_file_writes", false);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", false);
@@ -80,6 +80,19 @@ use_hw_renderer =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to load vertex attributes with compiled loaders. Only used together with the shader JIT,
+# in builds configured with ENABLE_VERTEX_LOADER_JIT
+# 0 (default): Off, 1: On
+use_vertex_loader_jit =
+
+# Minimum number of vertices for a draw call to be processed on several threads
+# 0 (default): Never process vertices on several threads, Otherwise the number of vertices
+parallel_vertex_threshold =
+
+# Number of shaded vertices that are kept for reuse by indexed draw calls
+# Rounded up to a power of two between 32 and 65536 (default: 1024)
+vertex_cache_size =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -144,6 +157,10 @@ output_device =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Whether to cache writes to save data and SD card files, and write them back in batches.
+# 0 (default): No, 1: Yes
+cache_file_writes =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS (default), 1: New 3DS
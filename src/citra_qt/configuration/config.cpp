@@ -73,6 +73,11 @@ void Config::ReadValues() {
     qt_config->beginGroup("Renderer");
     Settings::values.use_hw_renderer = qt_config->value("use_hw_renderer", true).toBool();
     Settings::values.use_shader_jit = qt_config->value("use_shader_jit", true).toBool();
+    Settings::values.use_vertex_loader_jit =
+        qt_config->value("use_vertex_loader_jit", false).toBool();
+    Settings::values.parallel_vertex_threshold =
+        qt_config->value("parallel_vertex_threshold", 0).toUInt();
+    Settings::values.vertex_cache_size = qt_config->value("vertex_cache_size", 1024).toUInt();
     Settings::values.resolution_factor = qt_config->value("resolution_factor", 1.0).toFloat();
     Settings::values.use_vsync = qt_config->value("use_vsync", false).toBool();
     Settings::values.toggle_framelimit = qt_config->value("toggle_framelimit", true).toBool();
@@ -123,6 +128,7 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = qt_config->value("use_virtual_sd", true).toBool();
+    Settings::values.cache_file_writes = qt_config->value("cache_file_writes", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -236,6 +242,9 @@ void Config::SaveValues() {
     qt_config->beginGroup("Renderer");
     qt_config->setValue("use_hw_renderer", Settings::values.use_hw_renderer);
     qt_config->setValue("use_shader_jit", Settings::values.use_shader_jit);
+    qt_config->setValue("use_vertex_loader_jit", Settings::values.use_vertex_loader_jit);
+    qt_config->setValue("parallel_vertex_threshold", Settings::values.parallel_vertex_threshold);
+    qt_config->setValue("vertex_cache_size", Settings::values.vertex_cache_size);
     qt_config->setValue("resolution_factor", (double)Settings::values.resolution_factor);
     qt_config->setValue("use_vsync", Settings::values.use_vsync);
     qt_config->setValue("toggle_framelimit", Settings::values.toggle_framelimit);
@@ -284,6 +293,7 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Data Storage");
     qt_config->setValue("use_virtual_sd", Settings::values.use_virtual_sd);
+    qt_config->setValue("cache_file_writes", Settings::values.cache_file_writes);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
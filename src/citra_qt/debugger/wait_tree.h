@@ -146,7 +146,7 @@ public:
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 
 private:
-    const std::vector<Kernel::SharedPtr<Kernel::Thread>>& thread_list;
+    const std::vector<Kernel::SharedPtr<Kernel::Thread>> thread_list;
 };
 
 class WaitTreeModel : public QAbstractItemModel {
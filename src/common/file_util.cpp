@@ -36,6 +36,7 @@
 #include <cstring>
 #include <dirent.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -57,6 +58,7 @@
 #endif
 
 #include <algorithm>
+#include <limits>
 #include <sys/stat.h>
 
 #ifndef S_ISDIR
@@ -889,4 +891,152 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+// Granularity of the file offsets mappings can start at
+static u64 GetMappingAlignment() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return static_cast<u64>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+MappedFile::MappedFile() {}
+
+MappedFile::MappedFile(const IOFile& file, u64 offset, u64 size) {
+    // Accessing a mapping past the end of the file would crash, so check that first
+    if (!file.IsOpen() || size == 0 || offset + size > file.GetSize())
+        return;
+
+    const u64 mapping_offset = offset - offset % GetMappingAlignment();
+    const u64 mapping_size = size + (offset - mapping_offset);
+    if (mapping_size > std::numeric_limits<size_t>::max())
+        return;
+
+#ifdef _WIN32
+    HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file.m_file)));
+    HANDLE mapping_handle =
+        CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        LOG_ERROR(Common_Filesystem, "CreateFileMapping failed: %s", GetLastErrorMsg());
+        return;
+    }
+    void* base =
+        MapViewOfFile(mapping_handle, FILE_MAP_READ, static_cast<DWORD>(mapping_offset >> 32),
+                      static_cast<DWORD>(mapping_offset), static_cast<SIZE_T>(mapping_size));
+    // The view keeps the file mapping object alive
+    CloseHandle(mapping_handle);
+    if (base == nullptr) {
+        LOG_ERROR(Common_Filesystem, "MapViewOfFile failed: %s", GetLastErrorMsg());
+        return;
+    }
+#else
+    void* base = mmap(nullptr, static_cast<size_t>(mapping_size), PROT_READ, MAP_SHARED,
+                      fileno(file.m_file), static_cast<off_t>(mapping_offset));
+    if (base == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "mmap failed: %s", GetLastErrorMsg());
+        return;
+    }
+#endif
+
+    m_mapping_base = base;
+    m_mapping_size = static_cast<size_t>(mapping_size);
+    m_data = static_cast<const u8*>(base) + (offset - mapping_offset);
+    m_size = size;
+}
+
+MappedFile::~MappedFile() {
+    Unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) {
+    Swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+    Swap(other);
+    return *this;
+}
+
+void MappedFile::Swap(MappedFile& other) {
+    std::swap(m_mapping_base, other.m_mapping_base);
+    std::swap(m_mapping_size, other.m_mapping_size);
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+}
+
+void MappedFile::Advise(AccessPattern pattern) const {
+    if (!IsOpen())
+        return;
+
+#ifdef _WIN32
+    // Windows has no equivalent of madvise, but does its own readahead for mapped files
+#else
+    int advice = MADV_NORMAL;
+    switch (pattern) {
+    case AccessPattern::Normal:
+        advice = MADV_NORMAL;
+        break;
+    case AccessPattern::Sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case AccessPattern::Random:
+        advice = MADV_RANDOM;
+        break;
+    }
+    madvise(m_mapping_base, m_mapping_size, advice);
+#endif
+}
+
+void MappedFile::Prefetch(u64 offset, u64 length) const {
+    if (!IsOpen() || offset >= m_size)
+        return;
+
+    // Prefetching works on whole pages
+    const u64 page_size = GetMappingAlignment();
+    const u64 start = (m_data - static_cast<const u8*>(m_mapping_base)) + offset;
+    const u64 end = start + std::min(length, m_size - offset);
+    const u64 aligned_start = start - start % page_size;
+    void* const address = static_cast<u8*>(m_mapping_base) + aligned_start;
+    const size_t size = static_cast<size_t>(end - aligned_start);
+
+#ifdef _WIN32
+    // PrefetchVirtualMemory only exists on Windows 8 and later, so it is looked up at runtime and
+    // prefetching does nothing on older versions. The range struct is declared here as the SDK
+    // only declares WIN32_MEMORY_RANGE_ENTRY when targeting Windows 8.
+    struct MemoryRangeEntry {
+        PVOID VirtualAddress;
+        SIZE_T NumberOfBytes;
+    };
+    using PrefetchVirtualMemoryFunc = BOOL(WINAPI*)(HANDLE, ULONG_PTR, MemoryRangeEntry*, ULONG);
+    static const auto prefetch_virtual_memory = reinterpret_cast<PrefetchVirtualMemoryFunc>(
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory"));
+    if (prefetch_virtual_memory == nullptr)
+        return;
+
+    MemoryRangeEntry range{address, size};
+    if (!prefetch_virtual_memory(GetCurrentProcess(), 1, &range, 0))
+        LOG_DEBUG(Common_Filesystem, "PrefetchVirtualMemory failed: %s", GetLastErrorMsg());
+#else
+    madvise(address, size, MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::Unmap() {
+    if (!IsOpen())
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_mapping_base);
+#else
+    munmap(m_mapping_base, m_mapping_size);
+#endif
+
+    m_mapping_base = nullptr;
+    m_mapping_size = 0;
+    m_data = nullptr;
+    m_size = 0;
+}
+
 } // namespace
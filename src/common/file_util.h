@@ -249,10 +249,65 @@ public:
     }
 
 private:
+    friend class MappedFile;
+
     std::FILE* m_file = nullptr;
     bool m_good = true;
 };
 
+// Read-only memory mapping of part of a file. This avoids a seek and a read syscall for every
+// access, and lets several users share the same data without each of them buffering it. The
+// mapping stays valid after the file it was created from is closed.
+class MappedFile : public NonCopyable {
+public:
+    // Hints about how the mapped data is going to be accessed, which let the OS tune its readahead
+    enum class AccessPattern {
+        Normal,
+        Sequential,
+        Random,
+    };
+
+    MappedFile();
+    // Maps `size` bytes of the file starting at `offset`. Check IsOpen() to see if this succeeded,
+    // which may not be the case e.g. on hosts with a small address space.
+    MappedFile(const IOFile& file, u64 offset, u64 size);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    void Swap(MappedFile& other);
+
+    bool IsOpen() const {
+        return nullptr != m_data;
+    }
+
+    const u8* GetData() const {
+        return m_data;
+    }
+
+    u64 GetSize() const {
+        return m_size;
+    }
+
+    // Tells the OS how the whole mapping is going to be accessed
+    void Advise(AccessPattern pattern) const;
+
+    // Asks the OS to start reading the given range of the mapping in the background. Does nothing
+    // on Windows versions before 8, which lack PrefetchVirtualMemory.
+    void Prefetch(u64 offset, u64 length) const;
+
+private:
+    void Unmap();
+
+    // The mapping itself starts at an aligned file offset, which m_data points somewhere into
+    void* m_mapping_base = nullptr;
+    size_t m_mapping_size = 0;
+    const u8* m_data = nullptr;
+    u64 m_size = 0;
+};
+
 } // namespace
 
 // To deal with Windows being dumb at unicode:
@@ -4,9 +4,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <deque>
 #include <boost/range/algorithm_ext/erase.hpp>
+#include "common/common_types.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace Common {
 
@@ -21,15 +27,13 @@ struct ThreadQueueList {
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
-    }
+    static_assert(N <= 64, "The priority bitmap only has room for 64 levels");
 
     // Only for debugging, returns priority level.
     Priority contains(const T& uid) {
         for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
+            std::deque<T>& cur = queues[i];
+            if (std::find(cur.cbegin(), cur.cend(), uid) != cur.cend()) {
                 return i;
             }
         }
@@ -38,124 +42,99 @@ struct ThreadQueueList {
     }
 
     T get_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
-        }
+        if (nonempty_queues == 0)
+            return T();
 
-        return T();
+        return queues[first_nonempty()].front();
     }
 
     T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
+        if (nonempty_queues == 0)
+            return T();
 
-        return T();
+        return pop_front(first_nonempty());
     }
 
     T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
+        if (nonempty_queues == 0)
+            return T();
 
-        return T();
+        const Priority first = first_nonempty();
+        if (first >= priority)
+            return T();
+
+        return pop_front(first);
     }
 
     void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
+        queues[priority].push_front(thread_id);
+        nonempty_queues |= bit(priority);
     }
 
     void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+        queues[priority].push_back(thread_id);
+        nonempty_queues |= bit(priority);
     }
 
     void move(const T& thread_id, Priority old_priority, Priority new_priority) {
         remove(old_priority, thread_id);
-        prepare(new_priority);
         push_back(new_priority, thread_id);
     }
 
     void remove(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        boost::remove_erase(cur->data, thread_id);
+        std::deque<T>& cur = queues[priority];
+        boost::remove_erase(cur, thread_id);
+        if (cur.empty())
+            nonempty_queues &= ~bit(priority);
     }
 
     void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
+        std::deque<T>& cur = queues[priority];
 
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
+        if (cur.size() > 1) {
+            cur.push_back(std::move(cur.front()));
+            cur.pop_front();
         }
     }
 
     void clear() {
-        queues.fill(Queue());
-        first = nullptr;
+        queues.fill(std::deque<T>());
+        nonempty_queues = 0;
     }
 
     bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
-    }
-
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        return queues[priority].empty();
     }
 
 private:
-    struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
-    };
-
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
+    static u64 bit(Priority priority) {
+        return u64(1) << priority;
     }
 
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
-
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
-        }
+    /// Returns the best priority level that has threads queued, nonempty_queues must not be 0.
+    Priority first_nonempty() const {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, nonempty_queues);
+        return static_cast<Priority>(index);
+#else
+        return static_cast<Priority>(__builtin_ctzll(nonempty_queues));
+#endif
+    }
 
-        cur->next_nonempty = first;
-        first = cur;
+    T pop_front(Priority priority) {
+        std::deque<T>& cur = queues[priority];
+        auto tmp = std::move(cur.front());
+        cur.pop_front();
+        if (cur.empty())
+            nonempty_queues &= ~bit(priority);
+        return tmp;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
+    // Bit i is set if there are threads queued at priority level i.
+    u64 nonempty_queues = 0;
     // The priority level queues of thread ids.
-    std::array<Queue, NUM_QUEUES> queues;
+    std::array<std::deque<T>, NUM_QUEUES> queues;
 };
 
 } // namespace
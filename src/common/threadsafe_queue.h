@@ -8,9 +8,12 @@
 // single reader, single writer queue
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
+#include <thread>
 #include "common/common_types.h"
 
 namespace Common {
@@ -119,4 +122,96 @@ public:
 private:
     std::mutex write_lock;
 };
+
+// a fixed-capacity lockless thread-safe,
+// single reader, multiple writer queue
+// Unlike MPSCQueue, pushing never allocates or blocks, but it fails when the queue is full.
+
+template <typename T, size_t Capacity>
+class BoundedMPSCQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    BoundedMPSCQueue() {
+        for (size_t i = 0; i < Capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /// Adds an element to the queue, or returns false if it is full.
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        size_t pos = write_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & (Capacity - 1)];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff =
+                static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                // the cell is free, try to claim it before another writer does
+                if (write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                // the cell still holds the element pushed one lap ago
+                return false;
+            } else {
+                // another writer claimed the cell first
+                pos = write_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::forward<Arg>(t);
+        // publish the element to the reader
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Only to be called from the reader thread.
+    bool Pop(T& t) {
+        Cell& cell = cells[read_pos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != read_pos + 1)
+            return false;
+
+        t = std::move(cell.data);
+        // hand the cell back to the writers for their next lap
+        cell.sequence.store(read_pos + Capacity, std::memory_order_release);
+        read_pos++;
+        return true;
+    }
+
+    /**
+     * Like Pop, but also returns the elements whose cells have been claimed by a writer that hasn't
+     * finished writing them yet, waiting for the writer. Only returns false once every element
+     * whose push had started has been read. Only to be called from the reader thread.
+     */
+    bool PopClaimed(T& t) {
+        if (read_pos == write_pos.load(std::memory_order_relaxed))
+            return false;
+
+        // Writers never block between claiming a cell and publishing it, so this is short
+        while (!Pop(t))
+            std::this_thread::yield();
+        return true;
+    }
+
+    /// Only to be called from the reader thread.
+    bool Empty() const {
+        const Cell& cell = cells[read_pos & (Capacity - 1)];
+        return cell.sequence.load(std::memory_order_acquire) != read_pos + 1;
+    }
+
+private:
+    struct Cell {
+        // Equal to the position of the next write to this cell while it is free, and to that
+        // position + 1 once the element has been written
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::array<Cell, Capacity> cells;
+    // keep the writer and reader positions on separate cache lines
+    alignas(64) std::atomic<size_t> write_pos{0};
+    alignas(64) size_t read_pos = 0;
+};
 } // namespace Common
@@ -7,7 +7,6 @@
 #include <memory>
 #include "core/arm/dyncom/arm_dyncom.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
-#include "core/arm/dyncom/arm_dyncom_trans.h"
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -27,12 +26,11 @@ void ARM_DynCom::Step() {
 }
 
 void ARM_DynCom::ClearInstructionCache() {
-    state->instruction_cache.clear();
-    trans_cache_buf_top = 0;
+    state->instruction_cache.Clear();
 }
 
-void ARM_DynCom::InvalidateCacheRange(u32, size_t) {
-    ClearInstructionCache();
+void ARM_DynCom::InvalidateCacheRange(u32 start_address, size_t length) {
+    state->instruction_cache.InvalidateRange(start_address, length);
 }
 
 void ARM_DynCom::PageTableChanged() {
@@ -91,6 +89,11 @@ void ARM_DynCom::ExecuteInstructions(int num_instructions) {
     state->NumInstrsToExecute = num_instructions;
     unsigned ticks_executed = InterpreterMainLoop(state.get());
     CoreTiming::AddTicks(ticks_executed);
+
+    if (state->idle_loop_detected) {
+        state->idle_loop_detected = false;
+        CoreTiming::SkipIdleLoop();
+    }
 }
 
 void ARM_DynCom::SaveContext(ThreadContext& ctx) {
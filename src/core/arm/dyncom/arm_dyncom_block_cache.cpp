@@ -0,0 +1,175 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+#include "core/arm/dyncom/arm_dyncom_trans.h"
+
+constexpr std::size_t BlockCache::INVALID_OFFSET;
+constexpr std::size_t BlockCache::REGION_SIZE;
+constexpr std::size_t BlockCache::NUM_REGIONS;
+constexpr std::size_t BlockCache::BLOCK_RESERVE;
+
+BlockCache::BlockCache() : pages(Memory::PAGE_TABLE_NUM_ENTRIES) {}
+
+BlockCache::~BlockCache() = default;
+
+void BlockCache::Insert(u32 pc, std::size_t offset) {
+    GetOrCreatePage(pc >> Memory::PAGE_BITS).entries[(pc & Memory::PAGE_MASK) >> 1] = offset;
+    regions[offset / REGION_SIZE].block_pcs.push_back(pc);
+}
+
+void BlockCache::AddLink(u32 target_pc, std::size_t* link_slot) {
+    GetOrCreatePage(target_pc >> Memory::PAGE_BITS).incoming_links.push_back(link_slot);
+}
+
+bool BlockCache::ReserveBlockSpace() {
+    const std::size_t region_start = current_region * REGION_SIZE;
+    if (trans_cache_buf_top + BLOCK_RESERVE <= region_start + REGION_SIZE)
+        return false;
+
+    regions[current_region].used_bytes = trans_cache_buf_top - region_start;
+    current_region = PickRegionToEvict();
+    trans_cache_buf_top = current_region * REGION_SIZE;
+
+    Region& region = regions[current_region];
+    region.used_bytes = 0;
+    if (region.block_pcs.empty())
+        return false;
+
+    EvictRegion(current_region);
+    return true;
+}
+
+void BlockCache::InvalidateRange(u32 start_address, std::size_t length) {
+    if (length == 0)
+        return;
+
+    const u64 end_address = std::min<u64>(u64(start_address) + length, u64(1) << 32);
+    const std::size_t first_page = start_address >> Memory::PAGE_BITS;
+    const std::size_t last_page = static_cast<std::size_t>((end_address - 1) >> Memory::PAGE_BITS);
+    for (std::size_t page_index = first_page; page_index <= last_page; ++page_index) {
+        InvalidatePage(page_index);
+    }
+}
+
+void BlockCache::Clear() {
+    // The translated blocks themselves are discarded along with the cache, so there is no need to
+    // reset the link slots here.
+    for (std::size_t page_index : allocated_pages) {
+        Page& page = *pages[page_index];
+        page.entries.fill(INVALID_OFFSET);
+        page.incoming_links.clear();
+    }
+
+    for (Region& region : regions) {
+        region.block_pcs.clear();
+        region.used_bytes = 0;
+        region.referenced = false;
+    }
+    current_region = 0;
+    clock_hand = 0;
+    trans_cache_buf_top = 0;
+}
+
+BlockCache::Stats BlockCache::GetStats() const {
+    Stats stats;
+    stats.occupied_bytes = trans_cache_buf_top - current_region * REGION_SIZE;
+    for (std::size_t i = 0; i < NUM_REGIONS; ++i) {
+        if (i != current_region)
+            stats.occupied_bytes += regions[i].used_bytes;
+    }
+    stats.evicted_regions = evicted_regions;
+    stats.evicted_blocks = evicted_blocks;
+    return stats;
+}
+
+BlockCache::Page& BlockCache::GetOrCreatePage(std::size_t page_index) {
+    auto& page = pages[page_index];
+    if (page == nullptr) {
+        page = std::make_unique<Page>();
+        page->entries.fill(INVALID_OFFSET);
+        allocated_pages.push_back(page_index);
+    }
+    return *page;
+}
+
+void BlockCache::InvalidatePage(std::size_t page_index) {
+    auto& page = pages[page_index];
+    if (page == nullptr)
+        return;
+
+    page->entries.fill(INVALID_OFFSET);
+    for (std::size_t* link_slot : page->incoming_links) {
+        *link_slot = INVALID_OFFSET;
+    }
+    page->incoming_links.clear();
+}
+
+std::size_t BlockCache::PickRegionToEvict() {
+    // Regions that have been entered since the hand last passed them get a second chance. This
+    // terminates after at most two rounds, as the hand clears the flags it passes over.
+    while (true) {
+        clock_hand = (clock_hand + 1) % NUM_REGIONS;
+        if (clock_hand == current_region)
+            continue;
+
+        Region& region = regions[clock_hand];
+        if (!region.referenced)
+            return clock_hand;
+        region.referenced = false;
+    }
+}
+
+void BlockCache::EvictRegion(std::size_t region_index) {
+    const std::size_t begin = region_index * REGION_SIZE;
+    const std::size_t end = begin + REGION_SIZE;
+    const auto in_region = [begin, end](std::size_t offset) {
+        return offset >= begin && offset < end;
+    };
+
+    // Blocks of this region may have been invalidated and translated again elsewhere since, so
+    // only drop entries that still point into this region.
+    Region& region = regions[region_index];
+    for (u32 pc : region.block_pcs) {
+        std::size_t& entry = pages[pc >> Memory::PAGE_BITS]->entries[(pc & Memory::PAGE_MASK) >> 1];
+        if (in_region(entry))
+            entry = INVALID_OFFSET;
+    }
+
+    // Forget the links held by blocks of this region, as their memory is about to be reused, and
+    // unlink branches that jump into this region.
+    const std::size_t* const region_memory_begin =
+        reinterpret_cast<const std::size_t*>(&trans_cache_buf[begin]);
+    const std::size_t* const region_memory_end =
+        reinterpret_cast<const std::size_t*>(&trans_cache_buf[begin] + REGION_SIZE);
+    for (std::size_t page_index : allocated_pages) {
+        auto& links = pages[page_index]->incoming_links;
+        links.erase(std::remove_if(links.begin(), links.end(),
+                                   [&](std::size_t* link_slot) {
+                                       if (link_slot >= region_memory_begin &&
+                                           link_slot < region_memory_end) {
+                                           return true;
+                                       }
+                                       if (in_region(*link_slot)) {
+                                           *link_slot = INVALID_OFFSET;
+                                           return true;
+                                       }
+                                       return false;
+                                   }),
+                    links.end());
+    }
+
+    const std::size_t num_blocks = region.block_pcs.size();
+    region.block_pcs.clear();
+    region.referenced = false;
+
+    evicted_regions++;
+    evicted_blocks += num_blocks;
+    MICROPROFILE_META_CPU("Evicted blocks", static_cast<int>(num_blocks));
+    LOG_DEBUG(Core_ARM11, "Evicted %zu blocks from translation cache region %zu", num_blocks,
+              region_index);
+}
@@ -0,0 +1,127 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+#include "core/memory.h"
+
+/**
+ * Maps guest PCs to the offset of their translated basic block in trans_cache_buf.
+ *
+ * This is a two-level table laid out like Memory::PageTable: the first level is indexed by the
+ * guest page number and the second level, which is only allocated for pages that actually contain
+ * translated code, by the halfword offset of the PC within that page. A lookup is therefore two
+ * dependent loads and no hashing. Since a translated block never crosses a page boundary (see
+ * TransExtData::END_OF_PAGE), invalidation can be done per page.
+ *
+ * The cache also keeps track of direct branches that have been linked to a block, so that these
+ * links can be undone when the page containing the target block is invalidated.
+ *
+ * Finally, it manages the space in trans_cache_buf: the buffer is split into fixed-size regions
+ * that blocks are translated into one after another. Once the last free region is full, the
+ * coldest region is picked with a second-chance (clock) scheme and all blocks in it are evicted.
+ */
+class BlockCache final {
+public:
+    /// Returned by Find when no block has been translated for the given PC.
+    static constexpr std::size_t INVALID_OFFSET = ~static_cast<std::size_t>(0);
+
+    static constexpr std::size_t REGION_SIZE = 2 * 1024 * 1024;
+    static constexpr std::size_t NUM_REGIONS = 64;
+    /// Space that must be left in a region before translating a block into it. A block never spans
+    /// more than one page, i.e. at most 2048 Thumb instructions of at most 44 bytes each.
+    static constexpr std::size_t BLOCK_RESERVE = 128 * 1024;
+
+    struct Stats {
+        /// Bytes of trans_cache_buf holding translated blocks, including invalidated ones.
+        std::size_t occupied_bytes;
+        /// Number of regions that were recycled because the cache was full.
+        u64 evicted_regions;
+        /// Number of blocks dropped as part of those regions.
+        u64 evicted_blocks;
+    };
+
+    BlockCache();
+    ~BlockCache();
+
+    /// Returns the trans_cache_buf offset of the block starting at `pc`, or INVALID_OFFSET.
+    std::size_t Find(u32 pc) const {
+        const auto& page = pages[pc >> Memory::PAGE_BITS];
+        if (page == nullptr)
+            return INVALID_OFFSET;
+        return page->entries[(pc & Memory::PAGE_MASK) >> 1];
+    }
+
+    /// Marks the region containing the block at `offset` as recently used.
+    void Touch(std::size_t offset) {
+        regions[offset / REGION_SIZE].referenced = true;
+    }
+
+    /// Records that the block starting at `pc` was translated at `offset` in trans_cache_buf.
+    void Insert(u32 pc, std::size_t offset);
+
+    /**
+     * Registers a branch that was linked to the block starting at `target_pc`.
+     * @param target_pc Guest address of the block the branch jumps to
+     * @param link_slot Location in trans_cache_buf holding the link, which will be reset to
+     *                  INVALID_OFFSET when the page containing `target_pc` is invalidated
+     */
+    void AddLink(u32 target_pc, std::size_t* link_slot);
+
+    /**
+     * Makes sure a block can be translated at trans_cache_buf_top, moving it to another region and
+     * evicting the blocks that were in there if the current one is full.
+     * @returns true if blocks were evicted, in which case any pointer into trans_cache_buf that
+     *          was obtained before the call must be considered stale.
+     */
+    bool ReserveBlockSpace();
+
+    /// Forgets all blocks in the pages overlapping [start_address, start_address + length).
+    void InvalidateRange(u32 start_address, std::size_t length);
+
+    /// Forgets all blocks and resets trans_cache_buf to empty.
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct Page {
+        /// One entry per halfword, since Thumb instructions are only 2-byte aligned.
+        std::array<std::size_t, Memory::PAGE_SIZE / 2> entries;
+        /// Link slots of branches jumping into blocks of this page.
+        std::vector<std::size_t*> incoming_links;
+    };
+
+    struct Region {
+        /// PCs of the blocks that were translated into this region.
+        std::vector<u32> block_pcs;
+        /// Bytes used by this region, only updated once translation moves on to another region.
+        std::size_t used_bytes = 0;
+        /// Set whenever a block in this region is entered, cleared by the eviction clock.
+        bool referenced = false;
+    };
+
+    Page& GetOrCreatePage(std::size_t page_index);
+    void InvalidatePage(std::size_t page_index);
+    std::size_t PickRegionToEvict();
+    void EvictRegion(std::size_t region_index);
+
+    std::vector<std::unique_ptr<Page>> pages;
+    /// Indices of the pages that currently have a second-level table allocated.
+    std::vector<std::size_t> allocated_pages;
+
+    std::array<Region, NUM_REGIONS> regions;
+    /// Region new blocks are currently being translated into.
+    std::size_t current_region = 0;
+    /// Position of the eviction clock hand.
+    std::size_t clock_hand = 0;
+
+    u64 evicted_regions = 0;
+    u64 evicted_blocks = 0;
+};
@@ -5,6 +5,7 @@
 #define CITRA_IGNORE_EXIT(x)
 
 #include <algorithm>
+#include <array>
 #include <cinttypes>
 #include <cstdio>
 #include "common/common_types.h"
@@ -805,6 +806,39 @@ static ThumbDecodeStatus DecodeThumbInstruction(u32 inst, u32 addr, u32* arm_ins
 
 enum { KEEP_GOING, FETCH_EXCEPTION };
 
+namespace {
+
+/// Guest state at the last time an idle loop candidate jumped back to its start.
+struct IdleLoopSnapshot {
+    bool valid = false;
+    u32 pc;
+    unsigned int num_instrs;
+    u32 nzcv;
+    std::array<u32, 15> regs;
+
+    /**
+     * Returns true if the loop ending with the current instruction ran exactly one iteration since
+     * the snapshot was taken and left the registers and flags unchanged. Otherwise, the snapshot is
+     * updated to the current state.
+     */
+    bool IsStuck(const ARMul_State* cpu, unsigned int cur_num_instrs, unsigned int loop_length) {
+        const u32 cur_nzcv = (cpu->NFlag << 3) | (cpu->ZFlag << 2) | (cpu->CFlag << 1) | cpu->VFlag;
+        if (valid && pc == cpu->Reg[15] && cur_num_instrs - num_instrs == loop_length &&
+            nzcv == cur_nzcv && std::equal(regs.begin(), regs.end(), cpu->Reg.begin())) {
+            return true;
+        }
+
+        valid = true;
+        pc = cpu->Reg[15];
+        num_instrs = cur_num_instrs;
+        nzcv = cur_nzcv;
+        std::copy_n(cpu->Reg.begin(), regs.size(), regs.begin());
+        return false;
+    }
+};
+
+} // Anonymous namespace
+
 MICROPROFILE_DEFINE(DynCom_Decode, "DynCom", "Decode", MP_RGB(255, 64, 64));
 
 static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, const u32 phys_addr,
@@ -853,21 +887,31 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
 
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
+    u32 last_inst_addr = phys_addr;
+    bool side_effect_free = true;
 
     while (ret == TransExtData::NON_BRANCH) {
         unsigned int inst_size = InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
 
         size++;
 
+        last_inst_addr = phys_addr;
         phys_addr += inst_size;
 
         if ((phys_addr & 0xfff) == 0) {
             inst_base->br = TransExtData::END_OF_PAGE;
         }
         ret = inst_base->br;
+
+        if (ret == TransExtData::NON_BRANCH && !IsSideEffectFree(inst_base))
+            side_effect_free = false;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    if (ret == TransExtData::DIRECT_BRANCH && side_effect_free)
+        MarkIdleLoopCandidate(inst_base, last_inst_addr, pc_start, size);
+
+    cpu->instruction_cache.Insert(pc_start, bb_start);
+    MICROPROFILE_META_CPU("Translated bytes", static_cast<int>(trans_cache_buf_top - bb_start));
 
     return KEEP_GOING;
 }
@@ -887,7 +931,7 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->instruction_cache.Insert(pc_start, bb_start);
 
     return KEEP_GOING;
 }
@@ -947,6 +991,25 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
         goto DISPATCH;                                                                             \
     inst_base = (arm_inst*)&trans_cache_buf[ptr]
 
+// Continues at the block a direct branch has been linked to, skipping the lookup in DISPATCH. If
+// the branch hasn't been linked yet, DISPATCH will link it to the block it finds.
+#define GOTO_LINKED_BLOCK(block)                                                                   \
+    if ((block) != BlockCache::INVALID_OFFSET) {                                                   \
+        ptr = (block);                                                                             \
+        goto ENTER_BLOCK;                                                                          \
+    }                                                                                              \
+    link_slot = &(block);                                                                          \
+    goto DISPATCH
+
+// Stops the interpreter if an idle loop candidate has just gone through an iteration without
+// changing any register. Since the loop has no other side effects, it will keep spinning until an
+// event changes the memory it polls, so the remaining cycles up to that event can be skipped.
+#define CHECK_IDLE_LOOP(length)                                                                    \
+    if ((length) != 0 && idle_loop.IsStuck(cpu, num_instrs, (length))) {                          \
+        cpu->idle_loop_detected = true;                                                            \
+        goto END;                                                                                  \
+    }
+
 #define INC_PC(l) ptr += sizeof(arm_inst) + l
 #define INC_PC_STUB ptr += sizeof(arm_inst)
 
@@ -1621,32 +1684,50 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
     unsigned int num_instrs = 0;
 
     std::size_t ptr;
+    // Link slot of the direct branch that sent us to DISPATCH, to be filled in with the offset of
+    // the block it jumps to once that has been looked up.
+    std::size_t* link_slot = nullptr;
+    IdleLoopSnapshot idle_loop;
 
     LOAD_NZCVT;
 DISPATCH : {
-    if (!cpu->NirqSig) {
-        if (!(cpu->Cpsr & 0x80)) {
-            goto END;
-        }
-    }
-
     if (cpu->TFlag)
         cpu->Reg[15] &= 0xfffffffe;
     else
         cpu->Reg[15] &= 0xfffffffc;
 
     // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
-    } else if (cpu->NumInstrsToExecute != 1) {
-        if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
-    } else {
-        if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+    ptr = cpu->instruction_cache.Find(cpu->Reg[15]);
+    if (ptr == BlockCache::INVALID_OFFSET) {
+        // Make room for the new block. The block holding the pending link might get evicted.
+        if (cpu->instruction_cache.ReserveBlockSpace()) {
+            link_slot = nullptr;
+        }
+
+        if (cpu->NumInstrsToExecute != 1) {
+            if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        } else {
+            if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        }
+    }
+
+    if (link_slot != nullptr) {
+        *link_slot = ptr;
+        cpu->instruction_cache.AddLink(cpu->Reg[15], link_slot);
+        link_slot = nullptr;
+    }
+}
+ENTER_BLOCK : {
+    if (!cpu->NirqSig) {
+        if (!(cpu->Cpsr & 0x80)) {
             goto END;
+        }
     }
 
+    cpu->instruction_cache.Touch(ptr);
+
     // Find breakpoint if one exists within the block
     if (GDBStub::IsConnected()) {
         breakpoint_data =
@@ -1756,18 +1837,17 @@ AND_INST : {
     GOTO_NEXT_INST;
 }
 BBL_INST : {
+    bbl_inst* inst_cream = (bbl_inst*)inst_base->component;
     if ((inst_base->cond == ConditionCode::AL) || CondPassed(cpu, inst_base->cond)) {
-        bbl_inst* inst_cream = (bbl_inst*)inst_base->component;
         if (inst_cream->L) {
             LINK_RTN_ADDR;
         }
         SET_PC;
-        INC_PC(sizeof(bbl_inst));
-        goto DISPATCH;
+        CHECK_IDLE_LOOP(inst_cream->idle_loop_length);
+        GOTO_LINKED_BLOCK(inst_cream->jmp_block);
     }
     cpu->Reg[15] += cpu->GetInstructionSize();
-    INC_PC(sizeof(bbl_inst));
-    goto DISPATCH;
+    GOTO_LINKED_BLOCK(inst_cream->next_block);
 }
 BIC_INST : {
     bic_inst* inst_cream = (bic_inst*)inst_base->component;
@@ -4314,19 +4394,19 @@ UMULL_INST : {
 B_2_THUMB : {
     b_2_thumb* inst_cream = (b_2_thumb*)inst_base->component;
     cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
-    INC_PC(sizeof(b_2_thumb));
-    goto DISPATCH;
+    CHECK_IDLE_LOOP(inst_cream->idle_loop_length);
+    GOTO_LINKED_BLOCK(inst_cream->jmp_block);
 }
 B_COND_THUMB : {
     b_cond_thumb* inst_cream = (b_cond_thumb*)inst_base->component;
 
-    if (CondPassed(cpu, inst_cream->cond))
+    if (CondPassed(cpu, inst_cream->cond)) {
         cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
-    else
-        cpu->Reg[15] += 2;
-
-    INC_PC(sizeof(b_cond_thumb));
-    goto DISPATCH;
+        CHECK_IDLE_LOOP(inst_cream->idle_loop_length);
+        GOTO_LINKED_BLOCK(inst_cream->jmp_block);
+    }
+    cpu->Reg[15] += 2;
+    GOTO_LINKED_BLOCK(inst_cream->next_block);
 }
 BL_1_THUMB : {
     bl_1_thumb* inst_cream = (bl_1_thumb*)inst_base->component;
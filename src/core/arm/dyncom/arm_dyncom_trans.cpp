@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "core/arm/dyncom/arm_dyncom_trans.h"
@@ -99,6 +101,9 @@ static ARM_INST_PTR INTERPRETER_TRANSLATE(bbl)(unsigned int inst, int index) {
 
     inst_cream->L = BIT(inst, 24);
     inst_cream->signed_immed_24 = BIT(inst, 23) ? NEGBRANCH : POSBRANCH;
+    inst_cream->idle_loop_length = 0;
+    inst_cream->next_block = BlockCache::INVALID_OFFSET;
+    inst_cream->jmp_block = BlockCache::INVALID_OFFSET;
 
     return inst_base;
 }
@@ -1646,6 +1651,8 @@ static ARM_INST_PTR INTERPRETER_TRANSLATE(b_2_thumb)(unsigned int tinst, int ind
     b_2_thumb* inst_cream = (b_2_thumb*)inst_base->component;
 
     inst_cream->imm = ((tinst & 0x3FF) << 1) | ((tinst & (1 << 10)) ? 0xFFFFF800 : 0);
+    inst_cream->idle_loop_length = 0;
+    inst_cream->jmp_block = BlockCache::INVALID_OFFSET;
 
     inst_base->idx = index;
     inst_base->br = TransExtData::DIRECT_BRANCH;
@@ -1659,6 +1666,9 @@ static ARM_INST_PTR INTERPRETER_TRANSLATE(b_cond_thumb)(unsigned int tinst, int
 
     inst_cream->imm = (((tinst & 0x7F) << 1) | ((tinst & (1 << 7)) ? 0xFFFFFF00 : 0));
     inst_cream->cond = ((tinst >> 8) & 0xf);
+    inst_cream->idle_loop_length = 0;
+    inst_cream->next_block = BlockCache::INVALID_OFFSET;
+    inst_cream->jmp_block = BlockCache::INVALID_OFFSET;
     inst_base->idx = index;
     inst_base->br = TransExtData::DIRECT_BRANCH;
 
@@ -1884,3 +1894,46 @@ const transop_fp_t arm_instruction_trans[] = {
 };
 
 const size_t arm_instruction_trans_len = sizeof(arm_instruction_trans) / sizeof(transop_fp_t);
+
+bool IsSideEffectFree(const arm_inst* inst) {
+    // Loads are included since guest processes can't map MMIO, so reading memory never has side
+    // effects. Exclusive loads are not, as they set the exclusive monitor.
+    static const transop_fp_t side_effect_free_ops[] = {
+        INTERPRETER_TRANSLATE(adc), INTERPRETER_TRANSLATE(add), INTERPRETER_TRANSLATE(and),
+        INTERPRETER_TRANSLATE(bic), INTERPRETER_TRANSLATE(clz), INTERPRETER_TRANSLATE(cmn),
+        INTERPRETER_TRANSLATE(cmp), INTERPRETER_TRANSLATE(cpy), INTERPRETER_TRANSLATE(eor),
+        INTERPRETER_TRANSLATE(ldm), INTERPRETER_TRANSLATE(ldr), INTERPRETER_TRANSLATE(ldrb),
+        INTERPRETER_TRANSLATE(ldrcond), INTERPRETER_TRANSLATE(ldrd), INTERPRETER_TRANSLATE(ldrh),
+        INTERPRETER_TRANSLATE(ldrsb), INTERPRETER_TRANSLATE(ldrsh), INTERPRETER_TRANSLATE(mla),
+        INTERPRETER_TRANSLATE(mov), INTERPRETER_TRANSLATE(mul), INTERPRETER_TRANSLATE(mvn),
+        INTERPRETER_TRANSLATE(nop), INTERPRETER_TRANSLATE(orr), INTERPRETER_TRANSLATE(pld),
+        INTERPRETER_TRANSLATE(rev), INTERPRETER_TRANSLATE(rev16), INTERPRETER_TRANSLATE(revsh),
+        INTERPRETER_TRANSLATE(rsb), INTERPRETER_TRANSLATE(rsc), INTERPRETER_TRANSLATE(sbc),
+        INTERPRETER_TRANSLATE(sub), INTERPRETER_TRANSLATE(sxtab), INTERPRETER_TRANSLATE(sxtah),
+        INTERPRETER_TRANSLATE(sxtb), INTERPRETER_TRANSLATE(sxth), INTERPRETER_TRANSLATE(teq),
+        INTERPRETER_TRANSLATE(tst), INTERPRETER_TRANSLATE(uxtab), INTERPRETER_TRANSLATE(uxtah),
+        INTERPRETER_TRANSLATE(uxtb), INTERPRETER_TRANSLATE(uxth), INTERPRETER_TRANSLATE(wfe),
+        INTERPRETER_TRANSLATE(yield),
+    };
+
+    const transop_fp_t op = arm_instruction_trans[inst->idx];
+    return std::find(std::begin(side_effect_free_ops), std::end(side_effect_free_ops), op) !=
+           std::end(side_effect_free_ops);
+}
+
+void MarkIdleLoopCandidate(arm_inst* inst, u32 pc, u32 block_start, unsigned int length) {
+    const transop_fp_t op = arm_instruction_trans[inst->idx];
+    if (op == INTERPRETER_TRANSLATE(bbl)) {
+        bbl_inst* const inst_cream = (bbl_inst*)inst->component;
+        if (!inst_cream->L && pc + 8 + inst_cream->signed_immed_24 == block_start)
+            inst_cream->idle_loop_length = length;
+    } else if (op == INTERPRETER_TRANSLATE(b_2_thumb)) {
+        b_2_thumb* const inst_cream = (b_2_thumb*)inst->component;
+        if (pc + 4 + inst_cream->imm == block_start)
+            inst_cream->idle_loop_length = length;
+    } else if (op == INTERPRETER_TRANSLATE(b_cond_thumb)) {
+        b_cond_thumb* const inst_cream = (b_cond_thumb*)inst->component;
+        if (pc + 4 + inst_cream->imm == block_start)
+            inst_cream->idle_loop_length = length;
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include "common/common_types.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
 
 struct ARMul_State;
 typedef unsigned int (*shtop_fp_t)(ARMul_State* cpu, unsigned int sht_oper);
@@ -79,11 +80,16 @@ struct eor_inst {
     shtop_fp_t shtop_func;
 };
 
+// The *_block members hold the trans_cache_buf offset of the block the branch was linked to, or
+// BlockCache::INVALID_OFFSET if it hasn't been linked yet. idle_loop_length is the number of
+// instructions in the block if the branch jumps back to the start of its own block and all other
+// instructions in it are free of side effects (see MarkIdleLoopCandidate), 0 otherwise.
 struct bbl_inst {
     unsigned int L;
     int signed_immed_24;
-    unsigned int next_addr;
-    unsigned int jmp_addr;
+    unsigned int idle_loop_length;
+    std::size_t next_block;
+    std::size_t jmp_block;
 };
 
 struct bx_inst {
@@ -447,10 +453,15 @@ struct setend_inst {
 
 struct b_2_thumb {
     unsigned int imm;
+    unsigned int idle_loop_length;
+    std::size_t jmp_block;
 };
 struct b_cond_thumb {
     unsigned int imm;
     unsigned int cond;
+    unsigned int idle_loop_length;
+    std::size_t next_block;
+    std::size_t jmp_block;
 };
 
 struct bl_1_thumb {
@@ -489,6 +500,20 @@ typedef ARM_INST_PTR (*transop_fp_t)(unsigned int, int);
 extern const transop_fp_t arm_instruction_trans[];
 extern const size_t arm_instruction_trans_len;
 
-#define TRANS_CACHE_SIZE (64 * 1024 * 2000)
+/// Returns whether `inst` only reads registers and memory and writes registers, so that executing
+/// it twice with the same register values and memory contents gives the same result.
+bool IsSideEffectFree(const arm_inst* inst);
+
+/**
+ * Flags the direct branch ending a block as an idle loop candidate if it jumps back to the start
+ * of that block. The caller must have checked that the rest of the block is side effect free.
+ * @param inst Branch instruction ending the block
+ * @param pc Guest address of the branch instruction
+ * @param block_start Guest address of the first instruction of the block
+ * @param length Number of instructions in the block, including the branch
+ */
+void MarkIdleLoopCandidate(arm_inst* inst, u32 pc, u32 block_start, unsigned int length);
+
+#define TRANS_CACHE_SIZE (BlockCache::REGION_SIZE * BlockCache::NUM_REGIONS)
 extern char trans_cache_buf[TRANS_CACHE_SIZE];
 extern size_t trans_cache_buf_top;
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cinttypes>
 #include <memory>
 #include <utility>
 #include "audio_core/audio_core.h"
@@ -191,6 +192,16 @@ void System::Shutdown() {
     Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                          perf_results.frametime * 1000.0);
 
+    // Log how much time was skipped by idle loop detection, to catch titles where it misfires
+    const u64 idle_loop_skips = CoreTiming::GetIdleLoopSkips();
+    const u64 idle_loop_ticks = CoreTiming::GetIdleLoopSkippedTicks();
+    LOG_INFO(Core, "Skipped %" PRIu64 " idle loops, %" PRIu64 " of %" PRIu64 " ticks",
+             idle_loop_skips, idle_loop_ticks, CoreTiming::GetTicks());
+    Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_IdleLoopSkips",
+                         idle_loop_skips);
+    Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_IdleLoopSkippedTicks",
+                         idle_loop_ticks);
+
     // Shutdown emulation session
     GDBStub::Shutdown();
     AudioCore::Shutdown();
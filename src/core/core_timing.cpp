@@ -5,6 +5,7 @@
 #include "core/core_timing.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <mutex>
 #include <string>
@@ -13,6 +14,7 @@
 #include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/thread.h"
 #include "common/threadsafe_queue.h"
 
@@ -25,6 +27,17 @@ static int downcount;
 struct EventType {
     TimedCallback callback;
     const std::string* name;
+    MicroProfileToken profile_token;
+
+    // The members below are updated through the const pointers held by the events, hence mutable.
+
+    // Slots in `events` of the queued events of this type, by their userdata
+    mutable std::unordered_map<u64, std::vector<size_t>> queued;
+
+    // Statistics reported by GetEventStats
+    mutable u64 fire_count;
+    mutable std::array<u64, NUM_LATENESS_BUCKETS> lateness_histogram;
+    mutable std::chrono::nanoseconds callback_time;
 };
 
 struct Event {
@@ -32,14 +45,20 @@ struct Event {
     u64 fifo_order;
     u64 userdata;
     const EventType* type;
+    // Position of the event in event_heap and in its list in type->queued, only valid while it is
+    // queued
+    size_t heap_index;
+    size_t type_index;
 };
 
-// Sort by time, unless the times are the same, in which case sort by the order added to the queue
-static bool operator>(const Event& left, const Event& right) {
-    return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
-}
+struct HeapEntry {
+    s64 time;
+    u64 fifo_order;
+    size_t slot;
+};
 
-static bool operator<(const Event& left, const Event& right) {
+// Sort by time, unless the times are the same, in which case sort by the order added to the queue
+static bool operator<(const HeapEntry& left, const HeapEntry& right) {
     return std::tie(left.time, left.fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
@@ -47,19 +66,33 @@ static bool operator<(const Event& left, const Event& right) {
 // remain stable regardless of rehashes/resizing.
 static std::unordered_map<std::string, EventType> event_types;
 
-// The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-// We don't use std::priority_queue because we need to be able to serialize, unserialize and
-// erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't accomodated
-// by the standard adaptor class.
-static std::vector<Event> event_queue;
+// The queue is an indexed binary min-heap. The events themselves are kept in `events`, at slots
+// that don't change while they are queued, and each event knows its position in event_heap and in
+// the list of queued events with its type and userdata. This allows unscheduling an event in
+// O(log n) instead of searching the whole queue and rebuilding the heap, which matters as services
+// reschedule their events all the time.
+static std::vector<Event> events;
+// Slots in `events` not used by a queued event
+static std::vector<size_t> free_slots;
+// The heap entries duplicate the sort key of their event to avoid an indirection when comparing.
+static std::vector<HeapEntry> event_heap;
 static u64 event_fifo_id;
 // the queue for storing the events from other threads threadsafe until they will be added
-// to the event_queue by the emu thread
-static Common::MPSCQueue<Event, false> ts_queue;
+// to the event queue by the emu thread
+static Common::BoundedMPSCQueue<Event, 512> ts_queue;
+// Events that didn't fit into ts_queue because the emu thread fell behind. This is slower as it
+// allocates and takes a lock, but never fails. Once an event went here, the later ones follow it
+// until the emu thread has moved them all, as they could otherwise overtake it through ts_queue.
+static std::mutex ts_overflow_mutex;
+static std::vector<Event> ts_overflow_events;
+static std::atomic<bool> ts_overflowed{false};
 
 static constexpr int MAX_SLICE_LENGTH = 20000;
 
 static s64 idled_cycles;
+// Number of times the CPU was found spinning in an idle loop and the cycles skipped because of it
+static u64 idle_loop_skips;
+static s64 idle_loop_cycles;
 
 // Are we in a function that has been called from Advance()
 // If events are sheduled from a function that gets called from Advance(),
@@ -78,14 +111,103 @@ EventType* RegisterEvent(const std::string& name, TimedCallback callback) {
                "during Init to avoid breaking save states.",
                name.c_str());
 
-    auto info = event_types.emplace(name, EventType{callback, nullptr});
+    auto info = event_types.emplace(name, EventType{callback, nullptr, 0, {}, 0, {}, {}});
     EventType* event_type = &info.first->second;
     event_type->name = &info.first->first;
+#if MICROPROFILE_ENABLED
+    // Every event type gets its own timer, so that expensive callbacks stand out in the profiler
+    event_type->profile_token = MicroProfileGetToken("CoreTiming", name.c_str(),
+                                                     MP_RGB(255, 160, 0), MicroProfileTokenTypeCpu);
+#endif
     return event_type;
 }
 
+static void SetHeapEntry(size_t heap_index, const HeapEntry& entry) {
+    event_heap[heap_index] = entry;
+    events[entry.slot].heap_index = heap_index;
+}
+
+static void SiftUp(size_t heap_index) {
+    const HeapEntry entry = event_heap[heap_index];
+    while (heap_index > 0) {
+        const size_t parent = (heap_index - 1) / 2;
+        if (!(entry < event_heap[parent]))
+            break;
+        SetHeapEntry(heap_index, event_heap[parent]);
+        heap_index = parent;
+    }
+    SetHeapEntry(heap_index, entry);
+}
+
+static void SiftDown(size_t heap_index) {
+    const HeapEntry entry = event_heap[heap_index];
+    const size_t size = event_heap.size();
+    while (true) {
+        size_t child = 2 * heap_index + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && event_heap[child + 1] < event_heap[child])
+            child++;
+        if (!(event_heap[child] < entry))
+            break;
+        SetHeapEntry(heap_index, event_heap[child]);
+        heap_index = child;
+    }
+    SetHeapEntry(heap_index, entry);
+}
+
+static void QueueEvent(const Event& event) {
+    size_t slot;
+    if (free_slots.empty()) {
+        slot = events.size();
+        events.emplace_back();
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+
+    Event& queued_event = events[slot];
+    queued_event = event;
+    std::vector<size_t>& queued = event.type->queued[event.userdata];
+    queued_event.type_index = queued.size();
+    queued.push_back(slot);
+
+    event_heap.push_back(HeapEntry{event.time, event.fifo_order, slot});
+    SiftUp(event_heap.size() - 1);
+}
+
+/// Removes the event at `heap_index` from the queue and returns it.
+static Event DequeueEvent(size_t heap_index) {
+    const size_t slot = event_heap[heap_index].slot;
+    const Event event = events[slot];
+
+    // Swap the event with the last one of its type and userdata so it can be removed from the back
+    const auto queued = event.type->queued.find(event.userdata);
+    const size_t last_of_type = queued->second.back();
+    queued->second[event.type_index] = last_of_type;
+    events[last_of_type].type_index = event.type_index;
+    queued->second.pop_back();
+    if (queued->second.empty())
+        event.type->queued.erase(queued);
+
+    // Likewise for the heap, where the last entry then needs to be moved to its proper place
+    const HeapEntry last_entry = event_heap.back();
+    event_heap.pop_back();
+    if (heap_index < event_heap.size()) {
+        SetHeapEntry(heap_index, last_entry);
+        if (heap_index > 0 && last_entry < event_heap[(heap_index - 1) / 2]) {
+            SiftUp(heap_index);
+        } else {
+            SiftDown(heap_index);
+        }
+    }
+
+    free_slots.push_back(slot);
+    return event;
+}
+
 void UnregisterAllEvents() {
-    ASSERT_MSG(event_queue.empty(), "Cannot unregister events with events pending");
+    ASSERT_MSG(event_heap.empty(), "Cannot unregister events with events pending");
     event_types.clear();
 }
 
@@ -94,6 +216,8 @@ void Init() {
     slice_length = MAX_SLICE_LENGTH;
     global_timer = 0;
     idled_cycles = 0;
+    idle_loop_skips = 0;
+    idle_loop_cycles = 0;
 
     // The time between CoreTiming being intialized and the first call to Advance() is considered
     // the slice boundary between slice -1 and slice 0. Dispatcher loops must call Advance() before
@@ -129,8 +253,21 @@ u64 GetIdleTicks() {
     return static_cast<u64>(idled_cycles);
 }
 
+u64 GetIdleLoopSkips() {
+    return idle_loop_skips;
+}
+
+u64 GetIdleLoopSkippedTicks() {
+    return static_cast<u64>(idle_loop_cycles);
+}
+
 void ClearPendingEvents() {
-    event_queue.clear();
+    for (auto& event_type : event_types) {
+        event_type.second.queued.clear();
+    }
+    events.clear();
+    free_slots.clear();
+    event_heap.clear();
 }
 
 void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
@@ -141,34 +278,30 @@ void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 user
     if (!is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
 
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+    QueueEvent(Event{timeout, event_fifo_id++, userdata, event_type});
 }
 
 void ScheduleEventThreadsafe(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
-    ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type});
+    const Event event{global_timer + cycles_into_future, 0, userdata, event_type};
+    if (!ts_overflowed.load(std::memory_order_acquire) && ts_queue.TryPush(event))
+        return;
+
+    std::lock_guard<std::mutex> lock(ts_overflow_mutex);
+    ts_overflowed.store(true, std::memory_order_relaxed);
+    ts_overflow_events.push_back(event);
 }
 
 void UnscheduleEvent(const EventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+    // Dequeuing the last event with the userdata also erases its list
+    for (auto queued = event_type->queued.find(userdata); queued != event_type->queued.end();
+         queued = event_type->queued.find(userdata)) {
+        DequeueEvent(events[queued->second.back()].heap_index);
     }
 }
 
 void RemoveEvent(const EventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+    while (!event_type->queued.empty()) {
+        DequeueEvent(events[event_type->queued.begin()->second.back()].heap_index);
     }
 }
 
@@ -190,8 +323,23 @@ void ForceExceptionCheck(s64 cycles) {
 void MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+        QueueEvent(ev);
+    }
+
+    if (ts_overflowed.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(ts_overflow_mutex);
+        // An event pushed to ts_queue before the overflow can still sit behind a cell that
+        // another thread is writing to, so wait for those before taking the overflowed ones
+        for (Event ev; ts_queue.PopClaimed(ev);) {
+            ev.fifo_order = event_fifo_id++;
+            QueueEvent(ev);
+        }
+        for (Event& ev : ts_overflow_events) {
+            ev.fifo_order = event_fifo_id++;
+            QueueEvent(ev);
+        }
+        ts_overflow_events.clear();
+        ts_overflowed.store(false, std::memory_order_relaxed);
     }
 }
 
@@ -204,19 +352,31 @@ void Advance() {
 
     is_global_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
-        event_queue.pop_back();
-        evt.type->callback(evt.userdata, global_timer - evt.time);
+    while (!event_heap.empty() && event_heap.front().time <= global_timer) {
+        const Event evt = DequeueEvent(0);
+        const s64 cycles_late = global_timer - evt.time;
+        const EventType* const type = evt.type;
+
+        size_t bucket = 0;
+        while (bucket < NUM_LATENESS_BUCKETS - 1 && (cycles_late >> bucket) != 0)
+            bucket++;
+        type->lateness_histogram[bucket]++;
+        type->fire_count++;
+
+        const auto callback_start = std::chrono::steady_clock::now();
+        {
+            MICROPROFILE_SCOPE_TOKEN(type->profile_token);
+            type->callback(evt.userdata, cycles_late);
+        }
+        type->callback_time += std::chrono::steady_clock::now() - callback_start;
     }
 
     is_global_timer_sane = false;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
+    if (!event_heap.empty()) {
         slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - global_timer, MAX_SLICE_LENGTH));
+            std::min<s64>(event_heap.front().time - global_timer, MAX_SLICE_LENGTH));
     }
 
     downcount = slice_length;
@@ -227,6 +387,12 @@ void Idle() {
     downcount = 0;
 }
 
+void SkipIdleLoop() {
+    idle_loop_skips++;
+    idle_loop_cycles += downcount;
+    Idle();
+}
+
 u64 GetGlobalTimeUs() {
     return GetTicks() * 1000000 / BASE_CLOCK_RATE_ARM11;
 }
@@ -235,4 +401,23 @@ int GetDowncount() {
     return downcount;
 }
 
+std::vector<EventStats> GetEventStats() {
+    std::vector<EventStats> stats;
+    stats.reserve(event_types.size());
+    for (const auto& event_type : event_types) {
+        stats.push_back(EventStats{event_type.first, event_type.second.fire_count,
+                                   event_type.second.lateness_histogram,
+                                   event_type.second.callback_time});
+    }
+    return stats;
+}
+
+void ResetEventStats() {
+    for (auto& event_type : event_types) {
+        event_type.second.fire_count = 0;
+        event_type.second.lateness_histogram.fill(0);
+        event_type.second.callback_time = std::chrono::nanoseconds::zero();
+    }
+}
+
 } // namespace CoreTiming
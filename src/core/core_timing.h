@@ -17,9 +17,12 @@
  *   ScheduleEvent(periodInCycles - cyclesLate, callback, "whatever")
  */
 
+#include <array>
+#include <chrono>
 #include <functional>
 #include <limits>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 
@@ -136,6 +139,10 @@ typedef std::function<void(u64 userdata, int cycles_late)> TimedCallback;
  */
 u64 GetTicks();
 u64 GetIdleTicks();
+/// Returns how many times SkipIdleLoop was called since Init.
+u64 GetIdleLoopSkips();
+/// Returns the part of GetIdleTicks that was skipped by SkipIdleLoop.
+u64 GetIdleLoopSkippedTicks();
 void AddTicks(u64 ticks);
 
 struct EventType;
@@ -179,6 +186,13 @@ void MoveEvents();
 /// Pretend that the main CPU has executed enough cycles to reach the next event.
 void Idle();
 
+/**
+ * Like Idle(), for when the CPU backend found the guest spinning in a loop that can't make
+ * progress before the next event. The skipped cycles are also counted separately, so that the
+ * effect of idle loop detection can be measured.
+ */
+void SkipIdleLoop();
+
 /// Clear all pending events. This should ONLY be done on exit.
 void ClearPendingEvents();
 
@@ -188,4 +202,28 @@ u64 GetGlobalTimeUs();
 
 int GetDowncount();
 
+/// Number of buckets in EventStats::lateness_histogram.
+constexpr size_t NUM_LATENESS_BUCKETS = 16;
+
+struct EventStats {
+    std::string name;
+    /// Number of times an event of this type fired.
+    u64 fire_count;
+    /**
+     * Bucket 0 counts the events that fired on time, bucket i > 0 those that fired between
+     * 2^(i-1) and 2^i - 1 cycles late. The last bucket also counts anything later than that.
+     */
+    std::array<u64, NUM_LATENESS_BUCKETS> lateness_histogram;
+    /// Host time spent in the callback.
+    std::chrono::nanoseconds callback_time;
+};
+
+/**
+ * Returns the statistics gathered in Advance() for every registered event type since it was
+ * registered or ResetEventStats() was last called. Like Advance(), this should only be called from
+ * the emu thread.
+ */
+std::vector<EventStats> GetEventStats();
+void ResetEventStats();
+
 } // namespace CoreTiming
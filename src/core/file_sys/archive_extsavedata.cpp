@@ -27,7 +27,8 @@ namespace FileSys {
  */
 class FixSizeDiskFile : public DiskFile {
 public:
-    FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode) : DiskFile(std::move(file), mode) {
+    FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode, std::string path)
+        : DiskFile(std::move(file), mode, std::move(path)) {
         size = GetSize();
     }
 
@@ -118,7 +119,7 @@ public:
         Mode rwmode;
         rwmode.write_flag.Assign(1);
         rwmode.read_flag.Assign(1);
-        auto disk_file = std::make_unique<FixSizeDiskFile>(std::move(file), rwmode);
+        auto disk_file = std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, full_path);
         return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
     }
 
@@ -82,7 +82,7 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
         return ERROR_NOT_FOUND;
     }
 
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode);
+    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, full_path);
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
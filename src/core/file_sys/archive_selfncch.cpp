@@ -68,7 +68,9 @@ public:
         return true;
     }
 
-    void Flush() const override {}
+    bool Flush() const override {
+        return true;
+    }
 
 private:
     std::shared_ptr<std::vector<u8>> data;
@@ -171,8 +173,9 @@ public:
 private:
     ResultVal<std::unique_ptr<FileBackend>> OpenRomFS() const {
         if (ncch_data.romfs_file) {
-            return MakeResult<std::unique_ptr<FileBackend>>(std::make_unique<IVFCFile>(
-                ncch_data.romfs_file, ncch_data.romfs_offset, ncch_data.romfs_size));
+            return MakeResult<std::unique_ptr<FileBackend>>(
+                std::make_unique<IVFCFile>(ncch_data.romfs_file, ncch_data.romfs_offset,
+                                           ncch_data.romfs_size, ncch_data.romfs_prefetcher));
         } else {
             LOG_INFO(Service_FS, "Unable to read RomFS");
             return ERROR_ROMFS_NOT_FOUND;
@@ -252,6 +255,14 @@ void ArchiveFactory_SelfNCCH::Register(Loader::AppLoader& app_loader) {
         app_loader.ReadRomFS(romfs_file_, data.romfs_offset, data.romfs_size)) {
 
         data.romfs_file = std::move(romfs_file_);
+
+        // Titles tend to read the same data in the same order on every boot, so record it and
+        // prefetch it the next time
+        if (program_id != 0) {
+            data.romfs_prefetcher = std::make_shared<RomFSPrefetcher>(
+                RomFSPrefetcher::GetTracePath(program_id), data.romfs_size,
+                MapRomFS(data.romfs_file, data.romfs_offset, data.romfs_size));
+        }
     }
 
     std::shared_ptr<FileUtil::IOFile> update_romfs_file;
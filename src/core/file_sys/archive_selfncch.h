@@ -10,6 +10,7 @@
 #include <vector>
 #include "common/common_types.h"
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/romfs_prefetcher.h"
 #include "core/hle/result.h"
 #include "core/loader/loader.h"
 
@@ -25,6 +26,7 @@ struct NCCHData {
     std::shared_ptr<FileUtil::IOFile> romfs_file;
     u64 romfs_offset = 0;
     u64 romfs_size = 0;
+    std::shared_ptr<RomFSPrefetcher> romfs_prefetcher;
 
     std::shared_ptr<FileUtil::IOFile> update_romfs_file;
     u64 update_romfs_offset = 0;
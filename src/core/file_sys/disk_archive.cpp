@@ -3,25 +3,145 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstdio>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include "common/common_paths.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/core_timing.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
 
 namespace FileSys {
 
+namespace {
+struct JournalHeader {
+    u32 magic;
+    u32 num_blocks;
+};
+
+struct JournalBlockHeader {
+    u64 offset;
+    u64 size;
+};
+} // namespace
+
+static constexpr u32 JOURNAL_MAGIC = 0x4C4E524A; // "JRNL"
+
+// Cached writes are written back once there is this much data cached, or once the oldest cached
+// data is this old, whichever happens first
+static constexpr size_t WRITE_BACK_MAX_DIRTY_BYTES = 4 * 1024 * 1024;
+static constexpr int WRITE_BACK_MAX_DELAY_MS = 5000;
+
+/// Writes back the cached writes of the file in userdata once the oldest of them got too old
+static CoreTiming::EventType* write_back_event = nullptr;
+
+/// Gets the path of the journal of a file. Journals are kept out of the emulated file system so
+/// that the guest never sees them.
+static std::string GetJournalPath(const std::string& path) {
+    return FileUtil::GetUserPath(D_USER_IDX) + "journal" DIR_SEP +
+           Common::StringFromFormat("%016" PRIX64, Common::ComputeHash64(path.data(), path.size()));
+}
+
+// Open files by host path. Caching writes is only done while a file is open once, as the caches
+// of several handles to the same file wouldn't see each other's data.
+static std::unordered_map<std::string, std::vector<DiskFile*>> open_files;
+
+DiskFile::DiskFile(FileUtil::IOFile&& file_, const Mode& mode_, std::string path_)
+    : file(new FileUtil::IOFile(std::move(file_))), path(std::move(path_)) {
+    mode.hex = mode_.hex;
+
+    std::vector<DiskFile*>& same_path = open_files[path];
+    if (same_path.empty()) {
+        ReplayJournal();
+        write_back = Settings::values.cache_file_writes && mode.write_flag;
+    } else {
+        for (DiskFile* other : same_path) {
+            other->WriteBack();
+            other->write_back = false;
+        }
+        write_back = false;
+    }
+    same_path.push_back(this);
+}
+
+DiskFile::~DiskFile() {
+    WriteBack();
+    if (write_back_event != nullptr)
+        CoreTiming::UnscheduleEvent(write_back_event, reinterpret_cast<u64>(this));
+
+    auto itr = open_files.find(path);
+    itr->second.erase(std::find(itr->second.begin(), itr->second.end(), this));
+    if (itr->second.empty())
+        open_files.erase(itr);
+}
+
 ResultVal<size_t> DiskFile::Read(const u64 offset, const size_t length, u8* buffer) const {
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
+    if (dirty_blocks.empty()) {
+        file->Seek(offset, SEEK_SET);
+        return MakeResult<size_t>(file->ReadBytes(buffer, length));
+    }
+
+    const u64 size = GetSize();
+    if (offset >= size)
+        return MakeResult<size_t>(0);
+    const size_t read_length = static_cast<size_t>(std::min<u64>(length, size - offset));
+
+    // Read what the host file has, the part of the file that only exists in the cache so far reads
+    // as zeroes until the cached data is copied over it
     file->Seek(offset, SEEK_SET);
-    return MakeResult<size_t>(file->ReadBytes(buffer, length));
+    const size_t host_read = std::min(file->ReadBytes(buffer, read_length), read_length);
+    std::memset(buffer + host_read, 0, read_length - host_read);
+
+    auto itr = dirty_blocks.upper_bound(offset);
+    if (itr != dirty_blocks.begin())
+        --itr;
+    const u64 read_end = offset + read_length;
+    for (; itr != dirty_blocks.end() && itr->first < read_end; ++itr) {
+        const u64 start = std::max(itr->first, offset);
+        const u64 end = std::min<u64>(itr->first + itr->second.size(), read_end);
+        if (start < end) {
+            std::memcpy(buffer + (start - offset), itr->second.data() + (start - itr->first),
+                        static_cast<size_t>(end - start));
+        }
+    }
+    return MakeResult<size_t>(read_length);
+}
+
+ResultVal<size_t> DiskFile::ReadScattered(const u64 offset,
+                                           const std::vector<Memory::HostRegion>& regions) const {
+    if (!mode.read_flag)
+        return ERROR_INVALID_OPEN_FLAGS;
+
+    // Cached data has to be merged into what is read, which Read takes care of
+    if (!dirty_blocks.empty())
+        return FileBackend::ReadScattered(offset, regions);
+
+    // The regions are consecutive in the file, so a single seek is enough
+    file->Seek(offset, SEEK_SET);
+    size_t total_read = 0;
+    for (const Memory::HostRegion& region : regions) {
+        const size_t read = file->ReadBytes(region.pointer, region.size);
+        total_read += read;
+        if (read != region.size)
+            break;
+    }
+    return MakeResult<size_t>(total_read);
 }
 
 ResultVal<size_t> DiskFile::Write(const u64 offset, const size_t length, const bool flush,
@@ -29,27 +149,225 @@ ResultVal<size_t> DiskFile::Write(const u64 offset, const size_t length, const b
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    size_t written = file->WriteBytes(buffer, length);
-    if (flush)
-        file->Flush();
-    return MakeResult<size_t>(written);
+    if (!write_back || length == 0) {
+        file->Seek(offset, SEEK_SET);
+        size_t written = file->WriteBytes(buffer, length);
+        if (flush)
+            file->Flush();
+        return MakeResult<size_t>(written);
+    }
+
+    // The flush flag is ignored here, as batching flushes is the point of the cache
+    if (dirty_blocks.empty() && write_back_event != nullptr) {
+        CoreTiming::ScheduleEvent(msToCycles(WRITE_BACK_MAX_DELAY_MS),
+                                  write_back_event, reinterpret_cast<u64>(this));
+    }
+    AddDirtyBlock(offset, buffer, length);
+
+    if (dirty_bytes >= WRITE_BACK_MAX_DIRTY_BYTES)
+        WriteBack();
+    return MakeResult<size_t>(length);
+}
+
+ResultVal<size_t> DiskFile::WriteGathered(const u64 offset,
+                                           const std::vector<Memory::HostRegion>& regions,
+                                           const bool flush) {
+    // Like in Write, the flush is left to the write back
+    return FileBackend::WriteGathered(offset, regions, flush && !write_back);
 }
 
 u64 DiskFile::GetSize() const {
-    return file->GetSize();
+    u64 size = file->GetSize();
+    if (!dirty_blocks.empty()) {
+        const auto& last_block = *dirty_blocks.rbegin();
+        size = std::max<u64>(size, last_block.first + last_block.second.size());
+    }
+    return size;
 }
 
 bool DiskFile::SetSize(const u64 size) const {
-    file->Resize(size);
-    file->Flush();
-    return true;
+    if (!WriteBack())
+        return false;
+    return file->Resize(size) && file->Flush();
 }
 
 bool DiskFile::Close() const {
+    // Keep the host file open if the cached data couldn't be written, so that it is tried again
+    // when the file is destroyed
+    if (!WriteBack())
+        return false;
     return file->Close();
 }
 
+bool DiskFile::Flush() const {
+    return WriteBack() && file->Flush();
+}
+
+void DiskFile::AddDirtyBlock(u64 offset, const u8* data, size_t length) {
+    if (length == 0)
+        return;
+    const u64 end = offset + length;
+
+    // Find the first block that overlaps or touches the written range
+    auto itr = dirty_blocks.upper_bound(offset);
+    if (itr != dirty_blocks.begin()) {
+        const auto previous = std::prev(itr);
+        if (previous->first + previous->second.size() >= offset)
+            itr = previous;
+    }
+
+    if (itr == dirty_blocks.end() || itr->first > end) {
+        dirty_blocks.emplace_hint(itr, offset, std::vector<u8>(data, data + length));
+        dirty_bytes += length;
+        return;
+    }
+
+    // Merge the written range and the blocks it touches into a single block. The first block is
+    // extended if it starts before the written range, which makes sequential writes cheap.
+    std::vector<u8> merged;
+    u64 merged_start = offset;
+    if (itr->first <= offset) {
+        merged_start = itr->first;
+        merged = std::move(itr->second);
+        dirty_bytes -= merged.size();
+        itr = dirty_blocks.erase(itr);
+    }
+    while (itr != dirty_blocks.end() && itr->first <= end) {
+        const size_t block_offset = static_cast<size_t>(itr->first - merged_start);
+        merged.resize(std::max(merged.size(), block_offset + itr->second.size()));
+        std::memcpy(merged.data() + block_offset, itr->second.data(), itr->second.size());
+        dirty_bytes -= itr->second.size();
+        itr = dirty_blocks.erase(itr);
+    }
+    merged.resize(std::max<size_t>(merged.size(), static_cast<size_t>(end - merged_start)));
+    std::memcpy(merged.data() + (offset - merged_start), data, length);
+
+    dirty_bytes += merged.size();
+    dirty_blocks.emplace_hint(itr, merged_start, std::move(merged));
+}
+
+bool DiskFile::WriteBack() const {
+    if (dirty_blocks.empty())
+        return true;
+
+    // If writing the blocks to the file is interrupted, the journal is replayed the next time the
+    // file is opened. It is only written as a temporary file and renamed into place once complete,
+    // so a journal that exists is always complete.
+    const std::string journal_path = GetJournalPath(path);
+    const bool journaled = WriteJournal(journal_path);
+    if (!journaled)
+        LOG_WARNING(Service_FS, "Could not write the journal of %s", path.c_str());
+
+    // Errors of an earlier write back that was tried again would stick to the file otherwise
+    file->Clear();
+    bool written = true;
+    for (const auto& block : dirty_blocks) {
+        file->Seek(block.first, SEEK_SET);
+        written = written && file->WriteBytes(block.second.data(), block.second.size()) ==
+                                 block.second.size();
+    }
+    written = written && file->Flush();
+    if (!written) {
+        LOG_ERROR(Service_FS, "Could not write back %zu cached bytes to %s", dirty_bytes,
+                  path.c_str());
+        return false;
+    }
+
+    if (journaled)
+        FileUtil::Delete(journal_path);
+
+    dirty_blocks.clear();
+    dirty_bytes = 0;
+    if (write_back_event != nullptr)
+        CoreTiming::UnscheduleEvent(write_back_event, reinterpret_cast<u64>(this));
+    return true;
+}
+
+bool DiskFile::WriteJournal(const std::string& journal_path) const {
+    if (!FileUtil::CreateFullPath(journal_path))
+        return false;
+
+    const std::string temp_path = journal_path + ".tmp";
+    FileUtil::IOFile journal(temp_path, "wb");
+    const JournalHeader header{JOURNAL_MAGIC, static_cast<u32>(dirty_blocks.size())};
+    bool written = journal.WriteObject(header) == 1;
+    for (const auto& block : dirty_blocks) {
+        const JournalBlockHeader block_header{block.first, block.second.size()};
+        written = written && journal.WriteObject(block_header) == 1 &&
+                  journal.WriteBytes(block.second.data(), block.second.size()) ==
+                      block.second.size();
+    }
+    written = written && journal.Close();
+#ifdef _WIN32
+    // Renaming doesn't replace the journal of an earlier write back that failed on Windows
+    written = written && FileUtil::Delete(journal_path);
+#endif
+
+    if (!written || !FileUtil::Rename(temp_path, journal_path)) {
+        journal.Close();
+        FileUtil::Delete(temp_path);
+        return false;
+    }
+    return true;
+}
+
+void DiskFile::ReplayJournal() const {
+    const std::string journal_path = GetJournalPath(path);
+    if (!FileUtil::Exists(journal_path))
+        return;
+
+    LOG_WARNING(Service_FS, "Recovering interrupted writes to %s", path.c_str());
+
+    // Use a separate handle, as this file may have been opened read-only
+    FileUtil::IOFile journal(journal_path, "rb");
+    FileUtil::IOFile target(path, "r+b");
+    JournalHeader header;
+    if (target.IsOpen() && journal.ReadBytes(&header, sizeof(header)) == sizeof(header) &&
+        header.magic == JOURNAL_MAGIC) {
+        std::vector<u8> data;
+        for (u32 i = 0; i < header.num_blocks; ++i) {
+            JournalBlockHeader block_header;
+            if (journal.ReadBytes(&block_header, sizeof(block_header)) != sizeof(block_header))
+                break;
+            data.resize(static_cast<size_t>(block_header.size));
+            if (journal.ReadBytes(data.data(), data.size()) != data.size())
+                break;
+            target.Seek(block_header.offset, SEEK_SET);
+            target.WriteBytes(data.data(), data.size());
+        }
+        target.Flush();
+    } else {
+        LOG_ERROR(Service_FS, "Could not replay the journal of %s", path.c_str());
+    }
+
+    journal.Close();
+    FileUtil::Delete(journal_path);
+}
+
+void DiskFile::WriteBackCallback(u64 userdata, int cycles_late) {
+    const DiskFile* file = reinterpret_cast<const DiskFile*>(userdata);
+    if (!file->WriteBack()) {
+        // Try again later, the data stays cached until then
+        CoreTiming::ScheduleEvent(msToCycles(WRITE_BACK_MAX_DELAY_MS) - cycles_late,
+                                  write_back_event, userdata);
+    }
+}
+
+void DiskArchiveInit() {
+    write_back_event = CoreTiming::RegisterEvent("DiskFile::WriteBackCallback",
+                                              DiskFile::WriteBackCallback);
+}
+
+void DiskArchiveShutdown() {
+    for (const auto& same_path : open_files) {
+        for (DiskFile* file : same_path.second) {
+            file->Flush();
+            CoreTiming::UnscheduleEvent(write_back_event, reinterpret_cast<u64>(file));
+        }
+    }
+    write_back_event = nullptr;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 DiskDirectory::DiskDirectory(const std::string& path) : directory() {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,28 +21,73 @@
 
 namespace FileSys {
 
+/**
+ * A file of the host file system.
+ *
+ * When the cache_file_writes setting is enabled, writes are cached in memory, where adjacent ones
+ * are merged, and written back to the host file in batches: when the guest flushes or closes the
+ * file, when too much data is cached, and from a CoreTiming event once the oldest cached data is a
+ * few seconds old. This avoids a host write and flush for
+ * each of the many small writes some titles save with. The batches are first committed to a
+ * journal, which is replayed when the file is opened again if the emulator crashed before the file
+ * itself was completely written. Writes aren't cached while the same file is open more than once.
+ */
 class DiskFile : public FileBackend {
 public:
-    DiskFile(FileUtil::IOFile&& file_, const Mode& mode_)
-        : file(new FileUtil::IOFile(std::move(file_))) {
-        mode.hex = mode_.hex;
-    }
+    /**
+     * @param file_ The opened host file
+     * @param mode_ The mode the file was opened with
+     * @param path_ Host path of the file, used to find its journal
+     */
+    DiskFile(FileUtil::IOFile&& file_, const Mode& mode_, std::string path_);
+    ~DiskFile() override;
 
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
+    ResultVal<size_t> ReadScattered(u64 offset,
+                                    const std::vector<Memory::HostRegion>& regions) const override;
     ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) override;
+    ResultVal<size_t> WriteGathered(u64 offset, const std::vector<Memory::HostRegion>& regions,
+                                    bool flush) override;
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
-
-    void Flush() const override {
-        file->Flush();
-    }
+    bool Flush() const override;
 
 protected:
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+
+private:
+    friend void DiskArchiveInit();
+
+    /// Adds written data to the cache, merging it with the cached blocks it overlaps or touches
+    void AddDirtyBlock(u64 offset, const u8* data, size_t length);
+    /**
+     * Writes the cached data back to the host file through the journal. If that fails, the data
+     * stays cached and the journal is kept, so that it can be tried again.
+     * @return true if there was no cached data left to write
+     */
+    bool WriteBack() const;
+    /// CoreTiming callback that writes back the cache of the file in userdata once it got old
+    static void WriteBackCallback(u64 userdata, int cycles_late);
+    bool WriteJournal(const std::string& journal_path) const;
+    /// Applies the journal left behind by a write back that didn't complete, if there is one
+    void ReplayJournal() const;
+
+    std::string path;
+    bool write_back;
+
+    /// Cached data that wasn't written back yet, as a map from offsets to blocks of data. Blocks
+    /// neither overlap nor touch each other.
+    mutable std::map<u64, std::vector<u8>> dirty_blocks;
+    mutable size_t dirty_bytes = 0;
 };
 
+/// Registers the CoreTiming event that writes back cached file writes once they get old
+void DiskArchiveInit();
+/// Writes back the cached writes of all open files and forgets the CoreTiming event
+void DiskArchiveShutdown();
+
 class DiskDirectory : public DirectoryBackend {
 public:
     DiskDirectory(const std::string& path);
@@ -5,8 +5,11 @@
 #pragma once
 
 #include <cstddef>
+#include <vector>
 #include "common/common_types.h"
+#include "core/file_sys/errors.h"
 #include "core/hle/result.h"
+#include "core/memory.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -37,6 +40,56 @@ public:
      */
     virtual ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) = 0;
 
+    /**
+     * Read data from the file into several buffers, filling each of them before moving on to the
+     * next one. This lets callers read straight into non-contiguous memory, such as the host
+     * memory backing a guest buffer. Backends that can do better than one Read per buffer should
+     * override this.
+     * @param offset Offset in bytes to start reading data from
+     * @param regions Buffers to read data into
+     * @return Number of bytes read, or error code
+     */
+    virtual ResultVal<size_t> ReadScattered(u64 offset,
+                                            const std::vector<Memory::HostRegion>& regions) const {
+        size_t total_read = 0;
+        for (const Memory::HostRegion& region : regions) {
+            ResultVal<size_t> read = Read(offset + total_read, region.size, region.pointer);
+            if (read.Failed())
+                return read.Code();
+            total_read += *read;
+            if (*read < region.size)
+                break;
+        }
+        return MakeResult<size_t>(total_read);
+    }
+
+    /**
+     * Write data from several buffers to the file, one after the other. This is the counterpart
+     * of ReadScattered.
+     * @param offset Offset in bytes to start writing data to
+     * @param regions Buffers to read data from
+     * @param flush The flush parameters (0 == do not flush)
+     * @return Number of bytes written, or error code
+     */
+    virtual ResultVal<size_t> WriteGathered(u64 offset,
+                                            const std::vector<Memory::HostRegion>& regions,
+                                            bool flush) {
+        size_t total_written = 0;
+        for (const Memory::HostRegion& region : regions) {
+            ResultVal<size_t> written =
+                Write(offset + total_written, region.size, false, region.pointer);
+            if (written.Failed())
+                return written.Code();
+            total_written += *written;
+            if (*written < region.size)
+                break;
+        }
+        // Only flush once everything has been written
+        if (flush && !Flush())
+            return ERROR_INSUFFICIENT_SPACE;
+        return MakeResult<size_t>(total_written);
+    }
+
     /**
      * Get the size of the file in bytes
      * @return Size of the file in bytes
@@ -58,8 +111,9 @@ public:
 
     /**
      * Flushes the file
+     * @return true if the data was written to the file
      */
-    virtual void Flush() const = 0;
+    virtual bool Flush() const = 0;
 };
 
 } // namespace FileSys
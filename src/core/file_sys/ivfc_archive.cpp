@@ -2,9 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/file_sys/ivfc_archive.h"
@@ -89,15 +91,99 @@ u64 IVFCArchive::GetFreeBytes() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-IVFCFile::IVFCFile(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size)
-    : romfs_file(std::move(file)), data_offset(offset), data_size(size) {}
+namespace {
+struct SharedMapping {
+    std::weak_ptr<FileUtil::IOFile> file;
+    u64 offset;
+    u64 size;
+    std::weak_ptr<const FileUtil::MappedFile> mapping;
+};
+} // namespace
+
+// Mappings of the RomFS images currently in use
+static std::vector<SharedMapping> shared_mappings;
+
+std::shared_ptr<const FileUtil::MappedFile> MapRomFS(const std::shared_ptr<FileUtil::IOFile>& file,
+                                                     u64 offset, u64 size) {
+    shared_mappings.erase(std::remove_if(shared_mappings.begin(), shared_mappings.end(),
+                                         [](const SharedMapping& shared_mapping) {
+                                             return shared_mapping.mapping.expired();
+                                         }),
+                          shared_mappings.end());
+
+    for (const SharedMapping& shared_mapping : shared_mappings) {
+        if (shared_mapping.file.lock() == file && shared_mapping.offset == offset &&
+            shared_mapping.size == size) {
+            return shared_mapping.mapping.lock();
+        }
+    }
+
+    auto mapping = std::make_shared<const FileUtil::MappedFile>(*file, offset, size);
+    if (!mapping->IsOpen()) {
+        LOG_WARNING(Service_FS, "Unable to map RomFS, falling back to regular reads");
+        return nullptr;
+    }
+    shared_mappings.push_back(SharedMapping{file, offset, size, mapping});
+    return mapping;
+}
+
+// Number of reads in a row that continue the previous one after which the file is considered to
+// be read sequentially
+static constexpr unsigned SEQUENTIAL_READ_THRESHOLD = 4;
+
+IVFCFile::IVFCFile(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size,
+                   std::shared_ptr<RomFSPrefetcher> prefetcher)
+    : romfs_file(std::move(file)), data_offset(offset), data_size(size),
+      prefetcher(std::move(prefetcher)) {
+    if (romfs_file != nullptr && romfs_file->IsOpen())
+        mapping = MapRomFS(romfs_file, data_offset, data_size);
+}
 
 ResultVal<size_t> IVFCFile::Read(const u64 offset, const size_t length, u8* buffer) const {
     LOG_TRACE(Service_FS, "called offset=%llu, length=%zu", offset, length);
-    romfs_file->Seek(data_offset + offset, SEEK_SET);
-    size_t read_length = (size_t)std::min((u64)length, data_size - offset);
+    const size_t read_length =
+        offset < data_size ? static_cast<size_t>(std::min<u64>(length, data_size - offset)) : 0;
+    if (prefetcher != nullptr)
+        prefetcher->RecordRead(offset, read_length);
+
+    if (mapping == nullptr) {
+        romfs_file->Seek(data_offset + offset, SEEK_SET);
+        return MakeResult<size_t>(romfs_file->ReadBytes(buffer, read_length));
+    }
+
+    TrackAccessPattern(offset, read_length);
+    std::memcpy(buffer, mapping->GetData() + offset, read_length);
+    return MakeResult<size_t>(read_length);
+}
 
-    return MakeResult<size_t>(romfs_file->ReadBytes(buffer, read_length));
+ResultVal<size_t> IVFCFile::ReadScattered(const u64 offset,
+                                           const std::vector<Memory::HostRegion>& regions) const {
+    LOG_TRACE(Service_FS, "called offset=%llu, regions=%zu", offset, regions.size());
+    u64 remaining = offset < data_size ? data_size - offset : 0;
+
+    if (mapping == nullptr)
+        romfs_file->Seek(data_offset + offset, SEEK_SET);
+
+    size_t total_read = 0;
+    for (const Memory::HostRegion& region : regions) {
+        const size_t length = static_cast<size_t>(std::min<u64>(region.size, remaining));
+        size_t read = length;
+        if (mapping == nullptr) {
+            read = romfs_file->ReadBytes(region.pointer, length);
+        } else {
+            std::memcpy(region.pointer, mapping->GetData() + offset + total_read, length);
+        }
+        total_read += read;
+        remaining -= read;
+        if (read != region.size)
+            break;
+    }
+
+    if (prefetcher != nullptr)
+        prefetcher->RecordRead(offset, total_read);
+    if (mapping != nullptr)
+        TrackAccessPattern(offset, total_read);
+    return MakeResult<size_t>(total_read);
 }
 
 ResultVal<size_t> IVFCFile::Write(const u64 offset, const size_t length, const bool flush,
@@ -116,4 +202,18 @@ bool IVFCFile::SetSize(const u64 size) const {
     return false;
 }
 
+void IVFCFile::TrackAccessPattern(u64 offset, u64 length) const {
+    // Only switch the readahead strategy once the pattern is clear, which also keeps the number of
+    // madvise calls low
+    if (offset == next_sequential_offset) {
+        if (++sequential_reads == SEQUENTIAL_READ_THRESHOLD)
+            mapping->Advise(FileUtil::MappedFile::AccessPattern::Sequential);
+    } else {
+        if (sequential_reads >= SEQUENTIAL_READ_THRESHOLD)
+            mapping->Advise(FileUtil::MappedFile::AccessPattern::Normal);
+        sequential_reads = 0;
+    }
+    next_sequential_offset = offset + length;
+}
+
 } // namespace FileSys
@@ -7,11 +7,13 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/romfs_prefetcher.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -50,23 +52,51 @@ protected:
 
 class IVFCFile : public FileBackend {
 public:
-    IVFCFile(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size);
+    /**
+     * @param prefetcher Prefetcher of the RomFS the file belongs to, which is told about the
+     *                   reads of the file. Can be null.
+     */
+    IVFCFile(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size,
+             std::shared_ptr<RomFSPrefetcher> prefetcher = nullptr);
 
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
+    ResultVal<size_t> ReadScattered(u64 offset,
+                                    const std::vector<Memory::HostRegion>& regions) const override;
     ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) override;
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override {
         return false;
     }
-    void Flush() const override {}
+    bool Flush() const override {
+        return true;
+    }
 
 private:
+    /// Adapts the readahead of the mapping to how the file is being read
+    void TrackAccessPattern(u64 offset, u64 length) const;
+
     std::shared_ptr<FileUtil::IOFile> romfs_file;
     u64 data_offset;
     u64 data_size;
+
+    /// Mapping of the file data, shared with the other files of the same RomFS. Reads go through
+    /// romfs_file instead if the mapping couldn't be created.
+    std::shared_ptr<const FileUtil::MappedFile> mapping;
+    std::shared_ptr<RomFSPrefetcher> prefetcher;
+    /// Offset right after the previous read, and how many reads in a row started there
+    mutable u64 next_sequential_offset = 0;
+    mutable unsigned sequential_reads = 0;
 };
 
+/**
+ * Maps the data of a RomFS. All the users of the same RomFS image share its mapping, which is
+ * released along with the last of them.
+ * @return The mapping, or null if the RomFS couldn't be mapped
+ */
+std::shared_ptr<const FileUtil::MappedFile> MapRomFS(const std::shared_ptr<FileUtil::IOFile>& file,
+                                                     u64 offset, u64 size);
+
 class IVFCDirectory : public DirectoryBackend {
 public:
     u32 Read(const u32 count, Entry* entries) override {
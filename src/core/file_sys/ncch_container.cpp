@@ -5,8 +5,13 @@
 #include <cinttypes>
 #include <cstring>
 #include <memory>
+#include <string>
+#include <vector>
+#include "common/common_paths.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/string_util.h"
 #include "core/core.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/loader/loader.h"
@@ -19,35 +24,24 @@ namespace FileSys {
 static const int kMaxSections = 8;   ///< Maximum number of sections (files) in an ExeFs
 static const int kBlockSize = 0x200; ///< Size of ExeFS blocks (in bytes)
 
-/**
- * Get the decompressed size of an LZSS compressed ExeFS file
- * @param buffer Buffer of compressed file
- * @param size Size of compressed buffer
- * @return Size of decompressed buffer
- */
-static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
+u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
     u32 offset_size = *(u32*)(buffer + size - 4);
     return offset_size + size;
 }
 
-/**
- * Decompress ExeFS file (compressed with LZSS)
- * @param compressed Compressed buffer
- * @param compressed_size Size of compressed buffer
- * @param decompressed Decompressed buffer
- * @param decompressed_size Size of decompressed buffer
- * @return True on success, otherwise false
- */
-static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
-                            u32 decompressed_size) {
+bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                     u32 decompressed_size) {
+    if (compressed_size < 8 || decompressed_size < compressed_size)
+        return false;
+
     const u8* footer = compressed + compressed_size - 8;
     u32 buffer_top_and_bottom = *reinterpret_cast<const u32*>(footer);
     u32 out = decompressed_size;
     u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
     u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
 
-    memset(decompressed, 0, decompressed_size);
     memcpy(decompressed, compressed, compressed_size);
+    memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
 
     while (index > stop_index) {
         u8 control = compressed[--index];
@@ -71,17 +65,35 @@ static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decom
                 segment_offset &= 0x0FFF;
                 segment_offset += 2;
 
-                // Check if compression is out of bounds
+                // Check if compression is out of bounds. The segment is copied backwards, so the
+                // first byte copied is the one read from the highest address.
                 if (out < segment_size)
                     return false;
+                if (out + segment_offset >= decompressed_size)
+                    return false;
 
-                for (unsigned j = 0; j < segment_size; j++) {
-                    // Check if compression is out of bounds
-                    if (out + segment_offset >= decompressed_size)
-                        return false;
-
-                    u8 data = decompressed[out + segment_offset];
-                    decompressed[--out] = data;
+                out -= segment_size;
+                u8* dest = decompressed + out;
+                const u8* src = dest + segment_offset + 1;
+                if (segment_offset + 1 >= segment_size && segment_size >= sizeof(u64)) {
+                    // The source doesn't overlap with the bytes being written, so the segment can
+                    // be copied with a few overlapping word sized loads, all done before storing
+                    u64 head, middle, tail;
+                    const u32 tail_offset = segment_size - sizeof(u64);
+                    const bool has_middle = segment_size > 2 * sizeof(u64);
+                    memcpy(&head, src, sizeof(u64));
+                    if (has_middle)
+                        memcpy(&middle, src + sizeof(u64), sizeof(u64));
+                    memcpy(&tail, src + tail_offset, sizeof(u64));
+                    memcpy(dest, &head, sizeof(u64));
+                    if (has_middle)
+                        memcpy(dest + sizeof(u64), &middle, sizeof(u64));
+                    memcpy(dest + tail_offset, &tail, sizeof(u64));
+                } else {
+                    // Bytes written by the copy may be read again by it, so they must be copied
+                    // one at a time, from the top down
+                    for (u32 j = segment_size; j-- > 0;)
+                        dest[j] = src[j];
                 }
             } else {
                 // Check if compression is out of bounds
@@ -95,6 +107,49 @@ static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decom
     return true;
 }
 
+/**
+ * Gets the path of the cached decompressed .code of a title. The cache is keyed by the program ID
+ * and a hash of the ExeFS header, which contains the SHA-256 hash of each section, so that it
+ * doesn't get stale when the title is updated or replaced.
+ */
+static std::string GetCodeCachePath(u64 program_id, const ExeFs_Header& exefs_header) {
+    const u64 exefs_hash = Common::ComputeHash64(&exefs_header, sizeof(ExeFs_Header));
+    return FileUtil::GetUserPath(D_CACHE_IDX) + "code" DIR_SEP +
+           Common::StringFromFormat("%016" PRIX64 "-%016" PRIX64 ".bin", program_id, exefs_hash);
+}
+
+static bool LoadCachedCode(const std::string& path, u32 size, std::vector<u8>& buffer) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen() || file.GetSize() != size)
+        return false;
+
+    buffer.resize(size);
+    if (file.ReadBytes(buffer.data(), size) != size)
+        return false;
+
+    LOG_DEBUG(Service_FS, "Loaded decompressed code from %s", path.c_str());
+    return true;
+}
+
+static void StoreCachedCode(const std::string& path, const std::vector<u8>& buffer) {
+    // Write to a temporary file first, so that a partially written file is never loaded
+    const std::string temp_path = path + ".tmp";
+    if (!FileUtil::CreateFullPath(path))
+        return;
+
+    FileUtil::IOFile file(temp_path, "wb");
+    bool written = file.WriteBytes(buffer.data(), buffer.size()) == buffer.size() && file.Close();
+#ifdef _WIN32
+    // Renaming doesn't replace existing files on Windows
+    written = written && FileUtil::Delete(path);
+#endif
+    if (!written || !FileUtil::Rename(temp_path, path)) {
+        LOG_WARNING(Service_FS, "Could not cache the decompressed code at %s", path.c_str());
+        file.Close();
+        FileUtil::Delete(temp_path);
+    }
+}
+
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset)
     : ncch_offset(ncch_offset), filepath(filepath) {
     file = FileUtil::IOFile(filepath, "rb");
@@ -291,7 +346,23 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             exefs_file.Seek(section_offset, SEEK_SET);
 
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
+                // Decompressing takes a while for big titles, so reuse the result of a previous
+                // boot when there is one. The decompressed size is stored at the end of the
+                // compressed data, and is used to validate the cached code.
+                if (section.size < sizeof(u32))
+                    return Loader::ResultStatus::ErrorInvalidFormat;
+                u32 size_difference;
+                exefs_file.Seek(section_offset + section.size - sizeof(u32), SEEK_SET);
+                if (exefs_file.ReadBytes(&size_difference, sizeof(u32)) != sizeof(u32))
+                    return Loader::ResultStatus::Error;
+
+                const std::string cache_path =
+                    GetCodeCachePath(ncch_header.program_id, exefs_header);
+                if (LoadCachedCode(cache_path, section.size + size_difference, buffer))
+                    return Loader::ResultStatus::Success;
+
                 // Section is compressed, read compressed .code section...
+                exefs_file.Seek(section_offset, SEEK_SET);
                 std::unique_ptr<u8[]> temp_buffer;
                 try {
                     temp_buffer.reset(new u8[section.size]);
@@ -307,6 +378,8 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                 buffer.resize(decompressed_size);
                 if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
+
+                StoreCachedCode(cache_path, buffer);
             } else {
                 // Section is uncompressed...
                 buffer.resize(section.size);
@@ -0,0 +1,216 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <iterator>
+#include <utility>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "common/thread.h"
+#include "core/file_sys/romfs_prefetcher.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+namespace {
+struct TraceHeader {
+    u32 magic;
+    u32 version;
+    u64 romfs_size;
+    u64 num_ranges;
+};
+} // namespace
+
+static constexpr u32 TRACE_MAGIC = 0x52544652; // "RFTR"
+static constexpr u32 TRACE_VERSION = 1;
+// Reads past this many non-contiguous ones aren't recorded, which keeps trace files small
+static constexpr size_t MAX_TRACE_RANGES = 0x10000;
+// How far the prefetch thread can get ahead of the guest. This keeps it from evicting data it
+// prefetched before the guest gets to use it.
+static constexpr u64 PREFETCH_WINDOW = 32 * 1024 * 1024;
+// Ranges are prefetched in chunks of this size, so that the prefetch thread stays responsive
+static constexpr u64 PREFETCH_CHUNK_SIZE = 1024 * 1024;
+// Distance between the bytes touched to fault the prefetched data in, which can't be larger than
+// the host page size
+static constexpr u64 TOUCH_STRIDE = 0x1000;
+
+/// Adds [start, end) to a set of non-overlapping ranges, merging it with the ranges it touches
+static void AddRange(std::map<u64, u64>& ranges, u64 start, u64 end) {
+    auto itr = ranges.upper_bound(start);
+    if (itr != ranges.begin() && std::prev(itr)->second >= start) {
+        --itr;
+        start = itr->first;
+        end = std::max(end, itr->second);
+        itr = ranges.erase(itr);
+    }
+    while (itr != ranges.end() && itr->first <= end) {
+        end = std::max(end, itr->second);
+        itr = ranges.erase(itr);
+    }
+    ranges.emplace(start, end);
+}
+
+RomFSPrefetcher::RomFSPrefetcher(std::string trace_path_, u64 romfs_size_,
+                                 std::shared_ptr<const FileUtil::MappedFile> mapping_)
+    : trace_path(std::move(trace_path_)), romfs_size(romfs_size_), mapping(std::move(mapping_)) {
+    if (mapping == nullptr || !LoadTrace())
+        return;
+
+    LOG_INFO(Service_FS, "Prefetching %zu RomFS ranges from %s", prefetch_list.size(),
+             trace_path.c_str());
+    prefetch_thread = std::thread(&RomFSPrefetcher::PrefetchThread, this);
+}
+
+RomFSPrefetcher::~RomFSPrefetcher() {
+    if (prefetch_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(prefetch_mutex);
+            stop_prefetching = true;
+        }
+        prefetch_cv.notify_all();
+        prefetch_thread.join();
+    }
+
+    const Stats final_stats = GetStats();
+    LOG_INFO(Service_FS,
+             "RomFS prefetch: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " bytes prefetched",
+             final_stats.hits, final_stats.misses, final_stats.prefetched_bytes);
+
+    SaveTrace();
+}
+
+std::string RomFSPrefetcher::GetTracePath(u64 program_id) {
+    return FileUtil::GetUserPath(D_CACHE_IDX) + "romfs_trace" DIR_SEP +
+           Common::StringFromFormat("%016" PRIX64 ".bin", program_id);
+}
+
+void RomFSPrefetcher::RecordRead(u64 offset, u64 length) {
+    if (length == 0)
+        return;
+
+    if (!trace.empty() && trace.back().offset + trace.back().length == offset) {
+        trace.back().length += length;
+    } else if (trace.size() < MAX_TRACE_RANGES) {
+        trace.push_back(Range{offset, length});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex);
+        if (IsPrefetched(offset, length)) {
+            stats.hits++;
+        } else {
+            stats.misses++;
+        }
+        guest_read_bytes += length;
+    }
+    prefetch_cv.notify_one();
+}
+
+RomFSPrefetcher::Stats RomFSPrefetcher::GetStats() const {
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    return stats;
+}
+
+bool RomFSPrefetcher::LoadTrace() {
+    FileUtil::IOFile file(trace_path, "rb");
+    if (!file.IsOpen())
+        return false;
+
+    TraceHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) || header.magic != TRACE_MAGIC ||
+        header.version != TRACE_VERSION || header.romfs_size != romfs_size ||
+        header.num_ranges > MAX_TRACE_RANGES) {
+        LOG_WARNING(Service_FS, "Ignoring invalid or outdated RomFS trace %s", trace_path.c_str());
+        return false;
+    }
+
+    prefetch_list.resize(static_cast<size_t>(header.num_ranges));
+    if (file.ReadArray(prefetch_list.data(), prefetch_list.size()) != prefetch_list.size()) {
+        LOG_WARNING(Service_FS, "Ignoring truncated RomFS trace %s", trace_path.c_str());
+        prefetch_list.clear();
+        return false;
+    }
+
+    prefetch_list.erase(std::remove_if(prefetch_list.begin(), prefetch_list.end(),
+                                       [this](const Range& range) {
+                                           return range.offset >= romfs_size ||
+                                                  range.length > romfs_size - range.offset;
+                                       }),
+                        prefetch_list.end());
+    return !prefetch_list.empty();
+}
+
+void RomFSPrefetcher::SaveTrace() const {
+    if (trace.empty() || !FileUtil::CreateFullPath(trace_path))
+        return;
+
+    // Write to a temporary file first, so that a partially written trace is never loaded
+    const std::string temp_path = trace_path + ".tmp";
+    FileUtil::IOFile file(temp_path, "wb");
+    const TraceHeader header{TRACE_MAGIC, TRACE_VERSION, romfs_size, trace.size()};
+    bool written = file.WriteObject(header) == 1 &&
+                   file.WriteArray(trace.data(), trace.size()) == trace.size() && file.Close();
+#ifdef _WIN32
+    // Renaming doesn't replace existing files on Windows
+    written = written && FileUtil::Delete(trace_path);
+#endif
+    if (!written || !FileUtil::Rename(temp_path, trace_path)) {
+        LOG_WARNING(Service_FS, "Could not save the RomFS trace to %s", trace_path.c_str());
+        file.Close();
+        FileUtil::Delete(temp_path);
+    }
+}
+
+void RomFSPrefetcher::PrefetchThread() {
+    Common::SetCurrentThreadName("RomFSPrefetch");
+
+    const u8* const data = mapping->GetData();
+    u64 prefetched_bytes = 0;
+
+    for (const Range& range : prefetch_list) {
+        const u64 range_end = range.offset + range.length;
+        for (u64 chunk = range.offset; chunk < range_end; chunk += PREFETCH_CHUNK_SIZE) {
+            const u64 chunk_end = std::min(chunk + PREFETCH_CHUNK_SIZE, range_end);
+            {
+                std::unique_lock<std::mutex> lock(prefetch_mutex);
+                prefetch_cv.wait(lock, [&] {
+                    return stop_prefetching ||
+                           prefetched_bytes <= guest_read_bytes + PREFETCH_WINDOW;
+                });
+                if (stop_prefetching)
+                    return;
+            }
+
+            // Start reading the whole chunk in the background, then fault it in page by page so
+            // that it's actually in memory once marked as prefetched
+            mapping->Prefetch(chunk, chunk_end - chunk);
+            volatile u8 touched;
+            for (u64 offset = chunk; offset < chunk_end; offset += TOUCH_STRIDE) {
+                touched = data[offset];
+            }
+            touched = data[chunk_end - 1];
+            (void)touched;
+
+            prefetched_bytes += chunk_end - chunk;
+            std::lock_guard<std::mutex> lock(prefetch_mutex);
+            AddRange(prefetched_ranges, chunk, chunk_end);
+            stats.prefetched_bytes += chunk_end - chunk;
+        }
+    }
+}
+
+bool RomFSPrefetcher::IsPrefetched(u64 offset, u64 length) const {
+    auto itr = prefetched_ranges.upper_bound(offset);
+    if (itr == prefetched_ranges.begin())
+        return false;
+    --itr;
+    return itr->second >= offset + length;
+}
+
+} // namespace FileSys
@@ -0,0 +1,92 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace FileUtil {
+class MappedFile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * Records the RomFS reads of the running title, in order, and saves them to a trace file when it
+ * is destroyed. When a trace from a previous session exists, a background thread reads the ranges
+ * it lists into the page cache ahead of the guest, which avoids stalling on cold reads when the
+ * same title is booted again.
+ */
+class RomFSPrefetcher : NonCopyable {
+public:
+    struct Stats {
+        /// Number of reads whose data had been prefetched completely
+        u64 hits = 0;
+        /// Number of reads whose data had not been prefetched, or only partially
+        u64 misses = 0;
+        u64 prefetched_bytes = 0;
+    };
+
+    /**
+     * @param trace_path Path of the trace file to load and then save
+     * @param romfs_size Size of the RomFS, traces recorded for another size are discarded
+     * @param mapping Mapping of the RomFS to prefetch through, nothing is prefetched if null
+     */
+    RomFSPrefetcher(std::string trace_path, u64 romfs_size,
+                    std::shared_ptr<const FileUtil::MappedFile> mapping);
+    ~RomFSPrefetcher();
+
+    /// Gets the path of the trace file of a title
+    static std::string GetTracePath(u64 program_id);
+
+    /// Records a read of the RomFS, and whether its data had been prefetched
+    void RecordRead(u64 offset, u64 length);
+
+    Stats GetStats() const;
+
+private:
+    struct Range {
+        u64 offset;
+        u64 length;
+    };
+
+    bool LoadTrace();
+    void SaveTrace() const;
+
+    void PrefetchThread();
+    /// Whether the given range has been prefetched completely. prefetch_mutex must be held.
+    bool IsPrefetched(u64 offset, u64 length) const;
+
+    std::string trace_path;
+    u64 romfs_size;
+    std::shared_ptr<const FileUtil::MappedFile> mapping;
+
+    /// Reads done during this session, with contiguous reads merged
+    std::vector<Range> trace;
+    /// Reads done during the previous session, which are being prefetched
+    std::vector<Range> prefetch_list;
+
+    mutable std::mutex prefetch_mutex;
+    std::condition_variable prefetch_cv;
+    bool stop_prefetching = false;
+    /// Prefetched ranges, as a map from the start offset to the end offset of each range
+    std::map<u64, u64> prefetched_ranges;
+    /// Number of bytes read by the guest, which the prefetch thread stays a bit ahead of
+    u64 guest_read_bytes = 0;
+    Stats stats;
+
+    std::thread prefetch_thread;
+};
+
+} // namespace FileSys
@@ -67,7 +67,7 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
         return ERROR_FILE_NOT_FOUND;
     }
 
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode);
+    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, full_path);
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -2,7 +2,6 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <algorithm>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/hle/kernel/address_arbiter.h"
@@ -18,50 +17,14 @@ namespace Kernel {
 void AddressArbiter::WaitThread(SharedPtr<Thread> thread, VAddr wait_address) {
     thread->wait_address = wait_address;
     thread->status = THREADSTATUS_WAIT_ARB;
-    waiting_threads.emplace_back(std::move(thread));
+    waiting_threads.Add(wait_address, std::move(thread));
 }
 
-void AddressArbiter::ResumeAllThreads(VAddr address) {
-    // Determine which threads are waiting on this address, those should be woken up.
-    auto itr = std::stable_partition(waiting_threads.begin(), waiting_threads.end(),
-                                     [address](const auto& thread) {
-                                         ASSERT_MSG(thread->status == THREADSTATUS_WAIT_ARB,
-                                                    "Inconsistent AddressArbiter state");
-                                         return thread->wait_address != address;
-                                     });
-
-    // Wake up all the found threads
-    std::for_each(itr, waiting_threads.end(), [](auto& thread) { thread->ResumeFromWait(); });
-
-    // Remove the woken up threads from the wait list.
-    waiting_threads.erase(itr, waiting_threads.end());
-}
-
-SharedPtr<Thread> AddressArbiter::ResumeHighestPriorityThread(VAddr address) {
-    // Determine which threads are waiting on this address, those should be considered for wakeup.
-    auto matches_start = std::stable_partition(
-        waiting_threads.begin(), waiting_threads.end(), [address](const auto& thread) {
-            ASSERT_MSG(thread->status == THREADSTATUS_WAIT_ARB,
-                       "Inconsistent AddressArbiter state");
-            return thread->wait_address != address;
-        });
-
-    // Iterate through threads, find highest priority thread that is waiting to be arbitrated.
-    // Note: The real kernel will pick the first thread in the list if more than one have the
-    // same highest priority value. Lower priority values mean higher priority.
-    auto itr = std::min_element(matches_start, waiting_threads.end(),
-                                [](const auto& lhs, const auto& rhs) {
-                                    return lhs->current_priority < rhs->current_priority;
-                                });
-
-    if (itr == waiting_threads.end())
-        return nullptr;
-
-    auto thread = *itr;
-    thread->ResumeFromWait();
-
-    waiting_threads.erase(itr);
-    return thread;
+void AddressArbiter::ResumeThreads(const std::vector<SharedPtr<Thread>>& threads) {
+    for (auto& thread : threads) {
+        ASSERT_MSG(thread->status == THREADSTATUS_WAIT_ARB, "Inconsistent AddressArbiter state");
+        thread->ResumeFromWait();
+    }
 }
 
 AddressArbiter::AddressArbiter() {}
@@ -82,8 +45,7 @@ ResultCode AddressArbiter::ArbitrateAddress(SharedPtr<Thread> thread, Arbitratio
                                    SharedPtr<WaitObject> object) {
         ASSERT(reason == ThreadWakeupReason::Timeout);
         // Remove the newly-awakened thread from the Arbiter's waiting list.
-        waiting_threads.erase(std::remove(waiting_threads.begin(), waiting_threads.end(), thread),
-                              waiting_threads.end());
+        waiting_threads.Remove(thread->wait_address, thread);
     };
 
     switch (type) {
@@ -92,11 +54,11 @@ ResultCode AddressArbiter::ArbitrateAddress(SharedPtr<Thread> thread, Arbitratio
     case ArbitrationType::Signal:
         // Negative value means resume all threads
         if (value < 0) {
-            ResumeAllThreads(address);
+            ResumeThreads(waiting_threads.TakeAll(address));
         } else {
             // Resume first N threads
-            for (int i = 0; i < value; i++)
-                ResumeHighestPriorityThread(address);
+            ResumeThreads(waiting_threads.TakeHighestPriority(
+                address, value, [](const auto& thread) { return thread->current_priority; }));
         }
         break;
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
@@ -29,6 +31,92 @@ enum class ArbitrationType : u32 {
     DecrementAndWaitIfLessThanWithTimeout,
 };
 
+/**
+ * Threads waiting on an address arbiter, keyed by the address they wait on and kept in the order
+ * they started waiting. Addresses without waiters are removed. Only the bookkeeping lives here,
+ * waking up the threads is left to the caller.
+ */
+template <typename T>
+class ArbitrationWaitList {
+public:
+    /// Adds a waiter to the end of the list of an address.
+    void Add(VAddr address, T waiter) {
+        lists[address].push_back(std::move(waiter));
+    }
+
+    /// Removes and returns all the waiters of an address, in the order they started waiting.
+    std::vector<T> TakeAll(VAddr address) {
+        auto list_itr = lists.find(address);
+        if (list_itr == lists.end())
+            return {};
+
+        std::vector<T> waiters = std::move(list_itr->second);
+        lists.erase(list_itr);
+        return waiters;
+    }
+
+    /**
+     * Removes and returns up to count waiters of an address, highest priority first, stopping
+     * early once the address has no waiters left.
+     * @param get_priority Returns the priority of a waiter. Priorities are compared here rather
+     *        than when a thread starts waiting, as they can change in between.
+     */
+    template <typename GetPriority>
+    std::vector<T> TakeHighestPriority(VAddr address, u32 count, GetPriority get_priority) {
+        std::vector<T> taken;
+        auto list_itr = lists.find(address);
+        if (list_itr == lists.end())
+            return taken;
+
+        std::vector<T>& waiters = list_itr->second;
+        while (taken.size() < count && !waiters.empty()) {
+            // Note: The real kernel will pick the first thread in the list if more than one have
+            // the same highest priority value. Lower priority values mean higher priority.
+            auto itr = std::min_element(waiters.begin(), waiters.end(),
+                                        [&get_priority](const T& lhs, const T& rhs) {
+                                            return get_priority(lhs) < get_priority(rhs);
+                                        });
+            taken.push_back(std::move(*itr));
+            waiters.erase(itr);
+        }
+
+        if (waiters.empty())
+            lists.erase(list_itr);
+        return taken;
+    }
+
+    /// Removes a waiter that stopped waiting on its own, returns whether it was found.
+    bool Remove(VAddr address, const T& waiter) {
+        auto list_itr = lists.find(address);
+        if (list_itr == lists.end())
+            return false;
+
+        std::vector<T>& waiters = list_itr->second;
+        auto itr = std::find(waiters.begin(), waiters.end(), waiter);
+        if (itr == waiters.end())
+            return false;
+
+        waiters.erase(itr);
+        if (waiters.empty())
+            lists.erase(list_itr);
+        return true;
+    }
+
+    /// Returns the number of waiters of an address.
+    size_t Count(VAddr address) const {
+        auto list_itr = lists.find(address);
+        return list_itr == lists.end() ? 0 : list_itr->second.size();
+    }
+
+    /// Returns the number of addresses that have waiters.
+    size_t NumAddresses() const {
+        return lists.size();
+    }
+
+private:
+    std::unordered_map<VAddr, std::vector<T>> lists;
+};
+
 class AddressArbiter final : public Object {
 public:
     /**
@@ -63,15 +151,11 @@ private:
     /// Puts the thread to wait on the specified arbitration address under this address arbiter.
     void WaitThread(SharedPtr<Thread> thread, VAddr wait_address);
 
-    /// Resume all threads found to be waiting on the address under this address arbiter
-    void ResumeAllThreads(VAddr address);
-
-    /// Resume one thread found to be waiting on the address under this address arbiter and return
-    /// the resumed thread.
-    SharedPtr<Thread> ResumeHighestPriorityThread(VAddr address);
+    /// Resumes the threads taken from the list of waiting threads
+    static void ResumeThreads(const std::vector<SharedPtr<Thread>>& threads);
 
-    /// Threads waiting for the address arbiter to be signaled.
-    std::vector<SharedPtr<Thread>> waiting_threads;
+    /// Threads waiting for the address arbiter to be signaled
+    ArbitrationWaitList<SharedPtr<Thread>> waiting_threads;
 };
 
 } // namespace Kernel
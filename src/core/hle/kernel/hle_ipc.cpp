@@ -214,4 +214,20 @@ void MappedBuffer::Write(const void* src_buffer, size_t offset, size_t size) {
     Memory::WriteBlock(*process, address + offset, src_buffer, size);
 }
 
+bool MappedBuffer::GetHostRegionsForRead(size_t offset, size_t size,
+                                         std::vector<Memory::HostRegion>& regions) {
+    ASSERT(perms & IPC::R);
+    ASSERT(offset + size <= this->size);
+    return Memory::GetHostRegions(*process, address + static_cast<VAddr>(offset), size,
+                                  Memory::FlushMode::Flush, regions);
+}
+
+bool MappedBuffer::GetHostRegionsForWrite(size_t offset, size_t size,
+                                          std::vector<Memory::HostRegion>& regions) {
+    ASSERT(perms & IPC::W);
+    ASSERT(offset + size <= this->size);
+    return Memory::GetHostRegions(*process, address + static_cast<VAddr>(offset), size,
+                                  Memory::FlushMode::FlushAndInvalidate, regions);
+}
+
 } // namespace Kernel
@@ -14,6 +14,7 @@
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/server_session.h"
+#include "core/memory.h"
 
 namespace Service {
 class ServiceFrameworkBase;
@@ -96,6 +97,18 @@ public:
     // interface for service
     void Read(void* dest_buffer, size_t offset, size_t size);
     void Write(const void* src_buffer, size_t offset, size_t size);
+
+    /**
+     * Gets the host memory backing part of the buffer, so that it can be read from (or written
+     * to, respectively) directly without a temporary copy.
+     * @return false if the buffer isn't entirely backed by host memory, in which case Read and
+     *         Write have to be used instead
+     */
+    bool GetHostRegionsForRead(size_t offset, size_t size,
+                               std::vector<Memory::HostRegion>& regions);
+    bool GetHostRegionsForWrite(size_t offset, size_t size,
+                                std::vector<Memory::HostRegion>& regions);
+
     size_t GetSize() const {
         return size;
     }
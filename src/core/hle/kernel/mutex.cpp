@@ -108,11 +108,7 @@ void Mutex::UpdatePriority() {
     if (!holding_thread)
         return;
 
-    u32 best_priority = THREADPRIO_LOWEST;
-    for (auto& waiter : GetWaitingThreads()) {
-        if (waiter->current_priority < best_priority)
-            best_priority = waiter->current_priority;
-    }
+    u32 best_priority = GetHighestWaitingPriority();
 
     if (best_priority != priority) {
         priority = best_priority;
@@ -345,7 +345,6 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     SharedPtr<Thread> thread(new Thread);
 
     thread_list.push_back(thread);
-    ready_queue.prepare(priority);
 
     thread->thread_id = NewThreadId();
     thread->status = THREADSTATUS_DORMANT;
@@ -421,10 +420,11 @@ void Thread::SetPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == THREADSTATUS_READY)
         ready_queue.move(this, current_priority, priority);
-    else
-        ready_queue.prepare(priority);
 
     nominal_priority = current_priority = priority;
+
+    for (auto& wait_object : wait_objects)
+        wait_object->UpdateWaitingThreadPriority(this);
 }
 
 void Thread::UpdatePriority() {
@@ -440,9 +440,10 @@ void Thread::BoostPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == THREADSTATUS_READY)
         ready_queue.move(this, current_priority, priority);
-    else
-        ready_queue.prepare(priority);
     current_priority = priority;
+
+    for (auto& wait_object : wait_objects)
+        wait_object->UpdateWaitingThreadPriority(this);
 }
 
 SharedPtr<Thread> SetupMainThread(u32 entry_point, u32 priority, SharedPtr<Process> owner_process) {
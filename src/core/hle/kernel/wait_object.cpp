@@ -18,54 +18,80 @@
 namespace Kernel {
 
 void WaitObject::AddWaitingThread(SharedPtr<Thread> thread) {
-    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
-    if (itr == waiting_threads.end())
-        waiting_threads.push_back(std::move(thread));
+    if (waiter_positions.count(thread.get()))
+        return;
+
+    Thread* const thread_ptr = thread.get();
+    const u32 priority = thread->current_priority;
+    const auto itr =
+        waiting_threads.insert(Waiter{priority, next_waiter_order++, std::move(thread)}).first;
+    waiter_positions.emplace(thread_ptr, itr);
 }
 
 void WaitObject::RemoveWaitingThread(Thread* thread) {
-    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
+    auto position = waiter_positions.find(thread);
     // If a thread passed multiple handles to the same object,
     // the kernel might attempt to remove the thread from the object's
     // waiting threads list multiple times.
-    if (itr != waiting_threads.end())
-        waiting_threads.erase(itr);
+    if (position == waiter_positions.end())
+        return;
+
+    waiting_threads.erase(position->second);
+    waiter_positions.erase(position);
 }
 
 SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
-    Thread* candidate = nullptr;
-    u32 candidate_priority = THREADPRIO_LOWEST + 1;
+    // The waiting threads are sorted by priority, so the first one that is ready wins.
+    for (const Waiter& waiter : waiting_threads) {
+        Thread* const thread = waiter.thread.get();
 
-    for (const auto& thread : waiting_threads) {
         // The list of waiting threads must not contain threads that are not waiting to be awakened.
         ASSERT_MSG(thread->status == THREADSTATUS_WAIT_SYNCH_ANY ||
                        thread->status == THREADSTATUS_WAIT_SYNCH_ALL ||
                        thread->status == THREADSTATUS_WAIT_HLE_EVENT,
                    "Inconsistent thread statuses in waiting_threads");
 
-        if (thread->current_priority >= candidate_priority)
-            continue;
-
-        if (ShouldWait(thread.get()))
+        if (ShouldWait(thread))
             continue;
 
         // A thread is ready to run if it's either in THREADSTATUS_WAIT_SYNCH_ANY or
         // in THREADSTATUS_WAIT_SYNCH_ALL and the rest of the objects it is waiting on are ready.
-        bool ready_to_run = true;
         if (thread->status == THREADSTATUS_WAIT_SYNCH_ALL) {
-            ready_to_run = std::none_of(thread->wait_objects.begin(), thread->wait_objects.end(),
-                                        [&thread](const SharedPtr<WaitObject>& object) {
-                                            return object->ShouldWait(thread.get());
-                                        });
+            const bool ready_to_run =
+                std::none_of(thread->wait_objects.begin(), thread->wait_objects.end(),
+                             [this, thread](const SharedPtr<WaitObject>& object) {
+                                 return object != this && object->ShouldWait(thread);
+                             });
+            if (!ready_to_run)
+                continue;
         }
 
-        if (ready_to_run) {
-            candidate = thread.get();
-            candidate_priority = thread->current_priority;
-        }
+        return thread;
     }
 
-    return candidate;
+    return nullptr;
+}
+
+void WaitObject::UpdateWaitingThreadPriority(Thread* thread) {
+    auto position = waiter_positions.find(thread);
+    if (position == waiter_positions.end())
+        return;
+
+    const WaiterSet::iterator itr = position->second;
+    if (itr->priority == thread->current_priority)
+        return;
+
+    // Keep the original order so the thread doesn't lose its place among equal priority threads.
+    Waiter waiter = *itr;
+    waiting_threads.erase(itr);
+    waiter.priority = thread->current_priority;
+    position->second = waiting_threads.insert(std::move(waiter)).first;
+}
+
+u32 WaitObject::GetHighestWaitingPriority() const {
+    if (waiting_threads.empty())
+        return THREADPRIO_LOWEST;
+    return waiting_threads.begin()->priority;
 }
 
 void WaitObject::WakeupAllWaitingThreads() {
@@ -90,8 +116,13 @@ void WaitObject::WakeupAllWaitingThreads() {
     }
 }
 
-const std::vector<SharedPtr<Thread>>& WaitObject::GetWaitingThreads() const {
-    return waiting_threads;
+std::vector<SharedPtr<Thread>> WaitObject::GetWaitingThreads() const {
+    std::vector<SharedPtr<Thread>> threads;
+    threads.reserve(waiting_threads.size());
+    for (const Waiter& waiter : waiting_threads) {
+        threads.push_back(waiter.thread);
+    }
+    return threads;
 }
 
 } // namespace Kernel
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <set>
+#include <unordered_map>
 #include <vector>
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 #include "common/common_types.h"
@@ -47,12 +49,43 @@ public:
     /// Obtains the highest priority thread that is ready to run from this object's waiting list.
     SharedPtr<Thread> GetHighestPriorityReadyThread();
 
-    /// Get a const reference to the waiting threads list for debug use
-    const std::vector<SharedPtr<Thread>>& GetWaitingThreads() const;
+    /**
+     * Moves a waiting thread to its new place in the waiting list after its priority changed.
+     * Does nothing if the thread isn't waiting on this object.
+     * @param thread Pointer to the thread whose priority changed
+     */
+    void UpdateWaitingThreadPriority(Thread* thread);
+
+    /// Returns the best priority among the waiting threads, or THREADPRIO_LOWEST if there are none
+    u32 GetHighestWaitingPriority() const;
+
+    /// Get a copy of the waiting threads list, in priority order, for debug use
+    std::vector<SharedPtr<Thread>> GetWaitingThreads() const;
 
 private:
-    /// Threads waiting for this object to become available
-    std::vector<SharedPtr<Thread>> waiting_threads;
+    struct Waiter {
+        /// Copy of the thread's current priority, which can't change while it is in the set
+        u32 priority;
+        /// Breaks ties between threads of the same priority, in favor of the one that waited first
+        u64 order;
+        SharedPtr<Thread> thread;
+    };
+
+    struct WaiterCompare {
+        bool operator()(const Waiter& lhs, const Waiter& rhs) const {
+            return lhs.priority < rhs.priority ||
+                   (lhs.priority == rhs.priority && lhs.order < rhs.order);
+        }
+    };
+
+    using WaiterSet = std::set<Waiter, WaiterCompare>;
+
+    /// Threads waiting for this object to become available, highest priority first
+    WaiterSet waiting_threads;
+    /// Position of each waiting thread in waiting_threads, so that it can be removed in O(1)
+    std::unordered_map<Thread*, WaiterSet::iterator> waiter_positions;
+    /// Value of Waiter::order for the next thread to start waiting
+    u64 next_waiter_order = 0;
 };
 
 // Specialization of DynamicObjectCast for WaitObjects
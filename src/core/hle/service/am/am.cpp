@@ -4,12 +4,21 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/title_metadata.h"
@@ -45,7 +54,6 @@ constexpr u32 TID_HIGH_DLC = 0x0004008C;
 static bool cia_installing = false;
 
 static bool lists_initialized = false;
-static std::array<std::vector<u64_le>, 3> am_title_list;
 
 struct TitleInfo {
     u64_le tid;
@@ -77,6 +85,33 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
+/// An installed title, as kept in the title index
+struct TitleIndexEntry {
+    // Only holds the title ID if the TMD of the title couldn't be loaded
+    TitleInfo info;
+    u32 has_tmd;
+    INSERT_PADDING_WORDS(1);
+    // Hash of the TMD the entry was made from, to tell whether a persisted entry is up to date
+    u64 tmd_hash;
+};
+
+static_assert(sizeof(TitleIndexEntry) == 0x28, "Title index entry structure size is wrong");
+
+struct TitleIndexHeader {
+    u32 magic;
+    u32 version;
+    u64 num_entries;
+};
+
+static constexpr u32 TITLE_INDEX_MAGIC = 0x58444954; // "TIDX"
+static constexpr u32 TITLE_INDEX_VERSION = 1;
+
+// The installed titles of each media type, by title ID. This is built when AM is initialized and
+// kept up to date by installs, so that title queries don't have to scan the file system. It can be
+// accessed by the frontend installing a CIA while the emulation runs, hence the mutex.
+static std::array<std::map<u64, TitleIndexEntry>, 3> title_index;
+static std::mutex title_index_mutex;
+
 ResultVal<size_t> CIAFile::Read(u64 offset, size_t length, u8* buffer) const {
     UNIMPLEMENTED();
     return MakeResult<size_t>(length);
@@ -112,6 +147,7 @@ ResultVal<size_t> CIAFile::WriteTitleMetadata(u64 offset, size_t length, const u
     FileUtil::CreateFullPath(app_folder);
 
     content_written.resize(container.GetTitleMetadata().GetContentCount());
+    content_files.resize(container.GetTitleMetadata().GetContentCount());
     install_state = CIAInstallState::TMDLoaded;
 
     return MakeResult<size_t>(length);
@@ -138,21 +174,30 @@ ResultVal<size_t> CIAFile::WriteContentData(u64 offset, size_t length, const u8*
             u64 available_to_write = std::min(offset_max, range_max) - range_min;
 
             // Since the incoming TMD has already been written, we can use GetTitleContentPath
-            // to get the content paths to write to.
-            FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            FileUtil::IOFile file(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update),
-                                  content_written[i] ? "ab" : "wb");
+            // to get the content paths to write to. The file is then kept open, rather than
+            // opened again for each buffer of its data.
+            FileUtil::IOFile& file = content_files[i];
+            if (!file.IsOpen()) {
+                const u64 title_id = container.GetTitleMetadata().GetTitleID();
+                file = FileUtil::IOFile(GetTitleContentPath(media_type, title_id, i, is_update),
+                                        content_written[i] ? "ab" : "wb");
+            }
 
             if (!file.IsOpen())
                 return FileSys::ERROR_INSUFFICIENT_SPACE;
 
-            file.WriteBytes(buffer + (range_min - offset), available_to_write);
+            if (file.WriteBytes(buffer + (range_min - offset), available_to_write) !=
+                available_to_write)
+                return FileSys::ERROR_INSUFFICIENT_SPACE;
 
             // Keep tabs on how much of this content ID has been written so new range_min
             // values can be calculated.
             content_written[i] += available_to_write;
             LOG_DEBUG(Service_AM, "Wrote %" PRIx64 " to content %u, total %" PRIx64,
                       available_to_write, i, content_written[i]);
+
+            if (content_written[i] == size && !file.Close())
+                return FileSys::ERROR_INSUFFICIENT_SPACE;
         }
     }
 
@@ -234,6 +279,15 @@ bool CIAFile::SetSize(u64 size) const {
 }
 
 bool CIAFile::Close() const {
+    // EndImportProgram closes the file before its last handle goes away, which closes it again
+    if (closed)
+        return true;
+    closed = true;
+
+    for (FileUtil::IOFile& file : content_files) {
+        file.Close();
+    }
+
     bool complete = true;
     for (size_t i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
         if (content_written[i] < container.GetContentSize(i))
@@ -244,6 +298,7 @@ bool CIAFile::Close() const {
     if (!complete) {
         LOG_ERROR(Service_AM, "CIAFile closed prematurely, aborting install...");
         FileUtil::DeleteDir(GetTitlePath(media_type, container.GetTitleMetadata().GetTitleID()));
+        UpdateTitleIndex(media_type, container.GetTitleMetadata().GetTitleID());
         return true;
     }
 
@@ -278,10 +333,131 @@ bool CIAFile::Close() const {
 
         FileUtil::Delete(old_tmd_path);
     }
+
+    UpdateTitleIndex(media_type, container.GetTitleMetadata().GetTitleID());
     return true;
 }
 
-void CIAFile::Flush() const {}
+bool CIAFile::Flush() const {
+    return true;
+}
+
+// CIAs are installed in chunks of this size, of which this many can be read ahead of the install
+constexpr size_t CIA_INSTALL_CHUNK_SIZE = 4 * 1024 * 1024;
+constexpr size_t CIA_INSTALL_CHUNK_COUNT = 3;
+
+namespace {
+/**
+ * Reads a CIA in chunks on a separate thread, ahead of the thread installing it, so that reading
+ * the CIA and writing its contents overlap.
+ */
+class CIAReader : NonCopyable {
+public:
+    struct Chunk {
+        std::vector<u8> data;
+        u64 offset = 0;
+        size_t size = 0;
+    };
+
+    explicit CIAReader(FileUtil::IOFile& file_) : file(file_), chunks(CIA_INSTALL_CHUNK_COUNT) {
+        for (Chunk& chunk : chunks) {
+            chunk.data.resize(CIA_INSTALL_CHUNK_SIZE);
+        }
+        read_thread = std::thread(&CIAReader::ReadThread, this);
+    }
+
+    ~CIAReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop_reading = true;
+        }
+        chunk_cv.notify_all();
+        read_thread.join();
+    }
+
+    /**
+     * Waits for the next chunk of the CIA to be read. It stays valid until ReleaseChunk is called.
+     * @returns the chunk, or nullptr once the whole CIA was returned or if reading it failed
+     */
+    const Chunk* WaitForChunk() {
+        std::unique_lock<std::mutex> lock(mutex);
+        chunk_cv.wait(lock, [this] { return chunks_read != chunks_installed || done_reading; });
+        if (chunks_read == chunks_installed)
+            return nullptr;
+        return &chunks[chunks_installed % chunks.size()];
+    }
+
+    /// Gives the chunk returned by WaitForChunk back to the reader thread
+    void ReleaseChunk() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            chunks_installed++;
+        }
+        chunk_cv.notify_all();
+    }
+
+    bool ReadFailed() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return read_failed;
+    }
+
+private:
+    void ReadThread() {
+        Common::SetCurrentThreadName("CIAReader");
+
+        const u64 size = file.GetSize();
+        u64 offset = 0;
+        bool failed = false;
+        while (offset < size && !failed) {
+            Chunk* chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunk_cv.wait(lock, [this] {
+                    return stop_reading || chunks_read - chunks_installed < chunks.size();
+                });
+                if (stop_reading)
+                    return;
+                chunk = &chunks[chunks_read % chunks.size()];
+            }
+
+            chunk->offset = offset;
+            chunk->size = file.ReadBytes(chunk->data.data(),
+                                         static_cast<size_t>(std::min<u64>(
+                                             size - offset, CIA_INSTALL_CHUNK_SIZE)));
+            offset += chunk->size;
+            failed = chunk->size == 0;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failed)
+                    chunks_read++;
+            }
+            chunk_cv.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            read_failed = failed;
+            done_reading = true;
+        }
+        chunk_cv.notify_all();
+    }
+
+    FileUtil::IOFile& file;
+    std::vector<Chunk> chunks;
+
+    mutable std::mutex mutex;
+    std::condition_variable chunk_cv;
+    // Chunks are used in order, as a ring buffer
+    size_t chunks_read = 0;
+    size_t chunks_installed = 0;
+    bool done_reading = false;
+    bool read_failed = false;
+    bool stop_reading = false;
+
+    std::thread read_thread;
+};
+} // namespace
 
 InstallStatus InstallCIA(const std::string& path,
                          std::function<ProgressCallback>&& update_callback) {
@@ -309,25 +485,37 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
-        std::array<u8, 0x10000> buffer;
-        size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
-            auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
-                                            static_cast<u8*>(buffer.data()));
-
-            if (update_callback)
-                update_callback(total_bytes_read, file.GetSize());
-            if (result.Failed()) {
-                LOG_ERROR(Service_AM, "CIA file installation aborted with error code %08x",
-                          result.Code().raw);
+        const u64 file_size = file.GetSize();
+        const auto start_time = std::chrono::steady_clock::now();
+        {
+            CIAReader reader(file);
+            while (const CIAReader::Chunk* chunk = reader.WaitForChunk()) {
+                auto result =
+                    installFile.Write(chunk->offset, chunk->size, true, chunk->data.data());
+                const u64 total_bytes_written = chunk->offset + chunk->size;
+                reader.ReleaseChunk();
+
+                if (update_callback)
+                    update_callback(static_cast<size_t>(total_bytes_written),
+                                    static_cast<size_t>(file_size));
+                if (result.Failed()) {
+                    LOG_ERROR(Service_AM, "CIA file installation aborted with error code %08x",
+                              result.Code().raw);
+                    return InstallStatus::ErrorAborted;
+                }
+            }
+
+            if (reader.ReadFailed()) {
+                LOG_ERROR(Service_AM, "Could not read %s, aborting...", path.c_str());
                 return InstallStatus::ErrorAborted;
             }
-            total_bytes_read += bytes_read;
         }
         installFile.Close();
 
-        LOG_INFO(Service_AM, "Installed %s successfully.", path.c_str());
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+        LOG_INFO(Service_AM, "Installed %s successfully, at %.1f MB/s.", path.c_str(),
+                 file_size / 1000000.0 / std::max(elapsed.count(), 1e-6));
         return InstallStatus::Success;
     }
 
@@ -454,8 +642,115 @@ std::string GetMediaTitlePath(Service::FS::MediaType media_type) {
     return "";
 }
 
+static std::string GetTitleIndexPath(Service::FS::MediaType media_type) {
+    return FileUtil::GetUserPath(D_CACHE_IDX) + "title_index" DIR_SEP +
+           Common::StringFromFormat("%u.bin", static_cast<u32>(media_type));
+}
+
+/// Fills in the information of a title from its TMD
+static bool LoadTitleInfo(Service::FS::MediaType media_type, u64 tid, TitleInfo& title_info) {
+    FileSys::TitleMetadata tmd;
+    if (tmd.Load(GetTitleMetadataPath(media_type, tid)) != Loader::ResultStatus::Success)
+        return false;
+
+    // TODO(shinyquagsire23): This is the total size of all files this process owns,
+    // including savefiles and other content. This comes close but is off.
+    title_info.size = tmd.GetContentSizeByIndex(FileSys::TMDContentIndex::Main);
+    title_info.version = tmd.GetTitleVersion();
+    title_info.type = tmd.GetTitleType();
+    return true;
+}
+
+/// Fills in the information of a title from the title index
+static bool FindIndexedTitleInfo(Service::FS::MediaType media_type, u64 tid,
+                                 TitleInfo& title_info) {
+    if (static_cast<u32>(media_type) >= title_index.size())
+        return false;
+
+    std::lock_guard<std::mutex> lock(title_index_mutex);
+    const std::map<u64, TitleIndexEntry>& index = title_index[static_cast<u32>(media_type)];
+    auto entry = index.find(tid);
+    if (entry == index.end() || !entry->second.has_tmd)
+        return false;
+
+    title_info = entry->second.info;
+    return true;
+}
+
+static u64 GetTitleMetadataHash(Service::FS::MediaType media_type, u64 tid) {
+    FileUtil::IOFile file(GetTitleMetadataPath(media_type, tid), "rb");
+    std::vector<u8> data(static_cast<size_t>(file.GetSize()));
+    data.resize(file.ReadBytes(data.data(), data.size()));
+    return Common::ComputeHash64(data.data(), data.size());
+}
+
+/**
+ * Makes the title index entry of a title from its files.
+ * @returns whether the title is installed
+ */
+static bool LoadTitleIndexEntry(Service::FS::MediaType media_type, u64 tid,
+                                TitleIndexEntry& entry) {
+    FileSys::NCCHContainer container(GetTitleContentPath(media_type, tid));
+    if (container.Load() != Loader::ResultStatus::Success)
+        return false;
+
+    entry = {};
+    entry.info.tid = tid;
+    entry.tmd_hash = GetTitleMetadataHash(media_type, tid);
+    entry.has_tmd = LoadTitleInfo(media_type, tid, entry.info) ? 1 : 0;
+    return true;
+}
+
+static std::map<u64, TitleIndexEntry> LoadTitleIndex(Service::FS::MediaType media_type) {
+    std::map<u64, TitleIndexEntry> index;
+    FileUtil::IOFile file(GetTitleIndexPath(media_type), "rb");
+    TitleIndexHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != TITLE_INDEX_MAGIC || header.version != TITLE_INDEX_VERSION)
+        return index;
+
+    for (u64 i = 0; i < header.num_entries; ++i) {
+        TitleIndexEntry entry;
+        if (file.ReadBytes(&entry, sizeof(entry)) != sizeof(entry))
+            break;
+        index.emplace(entry.info.tid, entry);
+    }
+    return index;
+}
+
+/// Persists the title index of a media type. title_index_mutex must be held.
+static void SaveTitleIndex(Service::FS::MediaType media_type) {
+    const std::string path = GetTitleIndexPath(media_type);
+    if (!FileUtil::CreateFullPath(path))
+        return;
+
+    // Write to a temporary file first, so that a partially written index is never loaded
+    const std::string temp_path = path + ".tmp";
+    const std::map<u64, TitleIndexEntry>& index = title_index[static_cast<u32>(media_type)];
+    FileUtil::IOFile file(temp_path, "wb");
+    const TitleIndexHeader header{TITLE_INDEX_MAGIC, TITLE_INDEX_VERSION, index.size()};
+    bool written = file.WriteObject(header) == 1;
+    for (const auto& entry : index) {
+        written = written && file.WriteObject(entry.second) == 1;
+    }
+    written = written && file.Close();
+#ifdef _WIN32
+    // Renaming doesn't replace existing files on Windows
+    written = written && FileUtil::Delete(path);
+#endif
+    if (!written || !FileUtil::Rename(temp_path, path)) {
+        LOG_WARNING(Service_AM, "Could not save the title index to %s", path.c_str());
+        file.Close();
+        FileUtil::Delete(temp_path);
+    }
+}
+
 void ScanForTitles(Service::FS::MediaType media_type) {
-    am_title_list[static_cast<u32>(media_type)].clear();
+    // The index saved by the previous session avoids loading the NCCH of every title again, its
+    // entries are still checked against the TMD of their title
+    const std::map<u64, TitleIndexEntry> saved_index = LoadTitleIndex(media_type);
+    std::map<u64, TitleIndexEntry> index;
+    bool index_changed = false;
 
     std::string title_path = GetMediaTitlePath(media_type);
 
@@ -466,11 +761,42 @@ void ScanForTitles(Service::FS::MediaType media_type) {
             std::string tid_string = tid_high.virtualName + tid_low.virtualName;
             u64 tid = std::stoull(tid_string.c_str(), nullptr, 16);
 
-            FileSys::NCCHContainer container(GetTitleContentPath(media_type, tid));
-            if (container.Load() == Loader::ResultStatus::Success)
-                am_title_list[static_cast<u32>(media_type)].push_back(tid);
+            auto saved_entry = saved_index.find(tid);
+            if (saved_entry != saved_index.end() &&
+                saved_entry->second.tmd_hash == GetTitleMetadataHash(media_type, tid)) {
+                index.emplace(*saved_entry);
+                continue;
+            }
+
+            TitleIndexEntry entry;
+            if (LoadTitleIndexEntry(media_type, tid, entry)) {
+                index.emplace(tid, entry);
+                index_changed = true;
+            } else if (saved_entry != saved_index.end()) {
+                index_changed = true;
+            }
         }
     }
+    index_changed = index_changed || index.size() != saved_index.size();
+
+    std::lock_guard<std::mutex> lock(title_index_mutex);
+    title_index[static_cast<u32>(media_type)] = std::move(index);
+    if (index_changed)
+        SaveTitleIndex(media_type);
+}
+
+void UpdateTitleIndex(Service::FS::MediaType media_type, u64 tid) {
+    TitleIndexEntry entry;
+    const bool installed = LoadTitleIndexEntry(media_type, tid, entry);
+
+    std::lock_guard<std::mutex> lock(title_index_mutex);
+    std::map<u64, TitleIndexEntry>& index = title_index[static_cast<u32>(media_type)];
+    if (installed) {
+        index[tid] = entry;
+    } else {
+        index.erase(tid);
+    }
+    SaveTitleIndex(media_type);
 }
 
 void ScanForAllTitles() {
@@ -482,9 +808,15 @@ void GetNumPrograms(Service::Interface* self) {
     IPC::RequestParser rp(Kernel::GetCommandBuffer(), 0x1, 1, 0); // 0x00010040
     u32 media_type = rp.Pop<u8>();
 
+    u32 num_programs = 0;
+    if (media_type < title_index.size()) {
+        std::lock_guard<std::mutex> lock(title_index_mutex);
+        num_programs = static_cast<u32>(title_index[media_type].size());
+    }
+
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
     rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(am_title_list[media_type].size());
+    rb.Push<u32>(num_programs);
 }
 
 void FindDLCContentInfos(Service::Interface* self) {
@@ -629,11 +961,18 @@ void GetProgramList(Service::Interface* self) {
         return;
     }
 
-    u32 media_count = static_cast<u32>(am_title_list[media_type].size());
-    u32 copied = std::min(media_count, count);
+    std::vector<u64_le> title_ids;
+    {
+        std::lock_guard<std::mutex> lock(title_index_mutex);
+        const std::map<u64, TitleIndexEntry>& index = title_index[media_type];
+        title_ids.reserve(std::min<size_t>(index.size(), count));
+        for (auto itr = index.begin(); itr != index.end() && title_ids.size() < count; ++itr) {
+            title_ids.push_back(itr->first);
+        }
+    }
+    u32 copied = static_cast<u32>(title_ids.size());
 
-    Memory::WriteBlock(title_ids_output_pointer, am_title_list[media_type].data(),
-                       copied * sizeof(u64));
+    Memory::WriteBlock(title_ids_output_pointer, title_ids.data(), copied * sizeof(u64));
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
     rb.Push(RESULT_SUCCESS);
@@ -643,19 +982,12 @@ void GetProgramList(Service::Interface* self) {
 ResultCode GetTitleInfoFromList(const std::vector<u64>& title_id_list,
                                 Service::FS::MediaType media_type, VAddr title_info_out) {
     for (u32 i = 0; i < title_id_list.size(); i++) {
-        std::string tmd_path = GetTitleMetadataPath(media_type, title_id_list[i]);
-
         TitleInfo title_info = {};
         title_info.tid = title_id_list[i];
 
-        FileSys::TitleMetadata tmd;
-        if (tmd.Load(tmd_path) == Loader::ResultStatus::Success) {
-            // TODO(shinyquagsire23): This is the total size of all files this process owns,
-            // including savefiles and other content. This comes close but is off.
-            title_info.size = tmd.GetContentSizeByIndex(FileSys::TMDContentIndex::Main);
-            title_info.version = tmd.GetTitleVersion();
-            title_info.type = tmd.GetTitleType();
-        } else {
+        // Indexed titles are served without touching the file system
+        if (!FindIndexedTitleInfo(media_type, title_id_list[i], title_info) &&
+            !LoadTitleInfo(media_type, title_id_list[i], title_info)) {
             return ResultCode(ErrorDescription::NotFound, ErrorModule::AM,
                               ErrorSummary::InvalidState, ErrorLevel::Permanent);
         }
@@ -893,6 +1225,39 @@ void CheckContentRightsIgnorePlatform(Service::Interface* self) {
     LOG_WARNING(Service_AM, "(STUBBED) tid=%016" PRIx64 ", content_index=%u", tid, content_index);
 }
 
+ResultVal<std::shared_ptr<Service::FS::File>> GetFileFromHandle(Kernel::Handle handle) {
+    // Step up the chain from Handle->ClientSession->ServerSession and then
+    // cast to File. For AM on 3DS, invalid handles actually hang the system.
+    auto file_session = Kernel::g_handle_table.Get<Kernel::ClientSession>(handle);
+
+    if (file_session == nullptr || file_session->parent == nullptr) {
+        LOG_WARNING(Service_AM, "Invalid file handle!");
+        return Kernel::ERR_INVALID_HANDLE;
+    }
+
+    Kernel::SharedPtr<Kernel::ServerSession> server = file_session->parent->server;
+    if (server == nullptr) {
+        LOG_WARNING(Service_AM, "File handle ServerSession disconnected!");
+        return Kernel::ERR_SESSION_CLOSED_BY_REMOTE;
+    }
+
+    if (server->hle_handler != nullptr) {
+        auto file = std::dynamic_pointer_cast<Service::FS::File>(server->hle_handler);
+
+        // TODO(shinyquagsire23): This requires RTTI, use service calls directly instead?
+        if (file != nullptr)
+            return MakeResult<std::shared_ptr<Service::FS::File>>(file);
+
+        LOG_ERROR(Service_AM, "Failed to cast handle to FSFile!");
+        return Kernel::ERR_INVALID_HANDLE;
+    }
+
+    // Probably the best bet if someone is LLEing the fs service is to just have them LLE AM
+    // while they're at it, so not implemented.
+    LOG_ERROR(Service_AM, "Given file handle does not have an HLE handler!");
+    return Kernel::ERR_NOT_IMPLEMENTED;
+}
+
 void BeginImportProgram(Service::Interface* self) {
     IPC::RequestParser rp(Kernel::GetCommandBuffer(), 0x0402, 1, 0); // 0x04020040
     auto media_type = static_cast<Service::FS::MediaType>(rp.Pop<u8>());
@@ -923,47 +1288,18 @@ void EndImportProgram(Service::Interface* self) {
     IPC::RequestParser rp(Kernel::GetCommandBuffer(), 0x0405, 0, 2); // 0x04050002
     auto cia_handle = rp.PopHandle();
 
+    // Finishing the install brings the title index up to date
+    auto file_res = GetFileFromHandle(cia_handle);
+    if (file_res.Succeeded())
+        file_res.Unwrap()->backend->Close();
+
     Kernel::g_handle_table.Close(cia_handle);
-    ScanForAllTitles();
 
     cia_installing = false;
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 }
 
-ResultVal<std::shared_ptr<Service::FS::File>> GetFileFromHandle(Kernel::Handle handle) {
-    // Step up the chain from Handle->ClientSession->ServerSession and then
-    // cast to File. For AM on 3DS, invalid handles actually hang the system.
-    auto file_session = Kernel::g_handle_table.Get<Kernel::ClientSession>(handle);
-
-    if (file_session == nullptr || file_session->parent == nullptr) {
-        LOG_WARNING(Service_AM, "Invalid file handle!");
-        return Kernel::ERR_INVALID_HANDLE;
-    }
-
-    Kernel::SharedPtr<Kernel::ServerSession> server = file_session->parent->server;
-    if (server == nullptr) {
-        LOG_WARNING(Service_AM, "File handle ServerSession disconnected!");
-        return Kernel::ERR_SESSION_CLOSED_BY_REMOTE;
-    }
-
-    if (server->hle_handler != nullptr) {
-        auto file = std::dynamic_pointer_cast<Service::FS::File>(server->hle_handler);
-
-        // TODO(shinyquagsire23): This requires RTTI, use service calls directly instead?
-        if (file != nullptr)
-            return MakeResult<std::shared_ptr<Service::FS::File>>(file);
-
-        LOG_ERROR(Service_AM, "Failed to cast handle to FSFile!");
-        return Kernel::ERR_INVALID_HANDLE;
-    }
-
-    // Probably the best bet if someone is LLEing the fs service is to just have them LLE AM
-    // while they're at it, so not implemented.
-    LOG_ERROR(Service_AM, "Given file handle does not have an HLE handler!");
-    return Kernel::ERR_NOT_IMPLEMENTED;
-}
-
 void GetProgramInfoFromCia(Service::Interface* self) {
     IPC::RequestParser rp(Kernel::GetCommandBuffer(), 0x0408, 1, 2); // 0x04080042
     auto media_type = static_cast<Service::FS::MediaType>(rp.Pop<u8>());
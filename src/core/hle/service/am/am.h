@@ -6,7 +6,9 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "core/file_sys/cia_container.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/result.h"
@@ -69,7 +71,7 @@ public:
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
-    void Flush() const override;
+    bool Flush() const override;
 
 private:
     // Whether it's installing an update, and what step of installation it is at
@@ -84,6 +86,13 @@ private:
     std::vector<u8> data;
     std::vector<u64> content_written;
     Service::FS::MediaType media_type;
+
+    // The .app file of each content, kept open from its first byte until it is completely
+    // written. Mutable as Close has to close the files of an aborted install before removing them.
+    mutable std::vector<FileUtil::IOFile> content_files;
+
+    // Whether Close already finished or aborted the install
+    mutable bool closed = false;
 };
 
 /**
@@ -148,6 +157,13 @@ void ScanForTitles(Service::FS::MediaType media_type);
  */
 void ScanForAllTitles();
 
+/**
+ * Updates the title listing after a title was installed or removed.
+ * @param media_type the storage medium the title is on
+ * @param tid the title ID of the title
+ */
+void UpdateTitleIndex(Service::FS::MediaType media_type, u64 tid);
+
 /**
  * AM::GetNumPrograms service function
  * Gets the number of installed titles in the requested media type
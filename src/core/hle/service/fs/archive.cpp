@@ -10,6 +10,7 @@
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -25,6 +26,7 @@
 #include "core/file_sys/archive_selfncch.h"
 #include "core/file_sys/archive_systemsavedata.h"
 #include "core/file_sys/directory_backend.h"
+#include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/ipc.h"
@@ -110,13 +112,22 @@ void File::Read(Kernel::HLERequestContext& ctx) {
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
-    std::vector<u8> data(length);
-    ResultVal<size_t> read = backend->Read(offset, data.size(), data.data());
+    // Read straight into the guest memory if possible, to avoid an allocation and a copy
+    ResultVal<size_t> read;
+    std::vector<Memory::HostRegion> regions;
+    if (buffer.GetHostRegionsForWrite(0, length, regions)) {
+        read = backend->ReadScattered(offset, regions);
+    } else {
+        std::vector<u8> data(length);
+        read = backend->Read(offset, data.size(), data.data());
+        if (read.Succeeded())
+            buffer.Write(data.data(), 0, *read);
+    }
+
     if (read.Failed()) {
         rb.Push(read.Code());
         rb.Push<u32>(0);
     } else {
-        buffer.Write(data.data(), 0, *read);
         rb.Push(RESULT_SUCCESS);
         rb.Push<u32>(*read);
     }
@@ -144,9 +155,16 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    // Write straight from the guest memory if possible, to avoid an allocation and a copy
+    ResultVal<size_t> written;
+    std::vector<Memory::HostRegion> regions;
+    if (buffer.GetHostRegionsForRead(0, length, regions)) {
+        written = backend->WriteGathered(offset, regions, flush != 0);
+    } else {
+        std::vector<u8> data(length);
+        buffer.Read(data.data(), 0, data.size());
+        written = backend->Write(offset, data.size(), flush != 0, data.data());
+    }
     if (written.Failed()) {
         rb.Push(written.Code());
         rb.Push<u32>(0);
@@ -181,8 +199,11 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    if (!backend->SetSize(size)) {
+        rb.Push(FileSys::ERROR_INSUFFICIENT_SPACE);
+        return;
+    }
     file->size = size;
-    backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
 }
 
@@ -194,9 +215,9 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but %zu clients still connected",
                     connected_sessions.size());
 
-    backend->Close();
+    const bool closed = backend->Close();
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
-    rb.Push(RESULT_SUCCESS);
+    rb.Push(closed ? RESULT_SUCCESS : FileSys::ERROR_INSUFFICIENT_SPACE);
 }
 
 void File::Flush(Kernel::HLERequestContext& ctx) {
@@ -212,8 +233,7 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    backend->Flush();
-    rb.Push(RESULT_SUCCESS);
+    rb.Push(backend->Flush() ? RESULT_SUCCESS : FileSys::ERROR_INSUFFICIENT_SPACE);
 }
 
 void File::SetPriority(Kernel::HLERequestContext& ctx) {
@@ -712,10 +732,12 @@ void ArchiveInit() {
     AddService(new FS::Interface);
 
     RegisterArchiveTypes();
+    FileSys::DiskArchiveInit();
 }
 
 /// Shutdown archives
 void ArchiveShutdown() {
+    FileSys::DiskArchiveShutdown();
     handle_map.clear();
     UnregisterArchiveTypes();
 }
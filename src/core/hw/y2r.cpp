@@ -5,7 +5,11 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -24,60 +28,205 @@ static const size_t MAX_TILES = 1024 / 8;
 static const size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
-/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
-static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
-                            const u8* input_V, ImageTile output[], unsigned int width,
-                            unsigned int height, const CoefficientSet& coefficients) {
+/// Gets the YUV values of a pixel of an image strip in the source YUV format
+template <InputFormat input_format>
+static void GetYUV(const u8* input_Y, const u8* input_U, const u8* input_V, unsigned int x,
+                   unsigned int y, unsigned int width, s32& Y, s32& U, s32& V) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        Y = input_Y[y * width + x];
+        U = input_U[(y * width + x) / 2];
+        V = input_V[(y * width + x) / 2];
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        Y = input_Y[y * width + x];
+        U = input_U[((y / 2) * width + x) / 2];
+        V = input_V[((y / 2) * width + x) / 2];
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        Y = input_Y[(y * width + x) * 2];
+        U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+        V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+        break;
+    }
+}
 
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y = 0;
-            s32 U = 0;
-            s32 V = 0;
-            switch (input_format) {
-            case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-                break;
-            case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-                break;
-            case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-                break;
-            }
+/// Converts a YUV tuple to RGB32
+static inline u32 ConvertPixel(s32 Y, s32 U, s32 V, const CoefficientSet& coefficients) {
+    // This conversion process is bit-exact with hardware, as far as could be tested.
+    auto& c = coefficients;
+    s32 cY = c[0] * Y;
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
+    s32 r = cY + c[1] * V;
+    s32 g = cY - c[2] * V - c[3] * U;
+    s32 b = cY + c[4] * U;
 
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
+    const s32 rounding_offset = 0x18;
+    r = (r >> 3) + c[5] + rounding_offset;
+    g = (g >> 3) + c[6] + rounding_offset;
+    b = (b >> 3) + c[7] + rounding_offset;
 
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
+    using MathUtil::Clamp;
+    return ((u32)Clamp(r >> 5, 0, 0xFF) << 24) | ((u32)Clamp(g >> 5, 0, 0xFF) << 16) |
+           ((u32)Clamp(b >> 5, 0, 0xFF) << 8);
+}
 
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
+#ifdef ARCHITECTURE_x86_64
+
+/// The coefficients, arranged to be used with pmaddwd on vectors of interleaved 16-bit values
+struct SSECoefficients {
+    explicit SSECoefficients(const CoefficientSet& c) {
+        const auto pair = [](s16 first, s16 second) {
+            return _mm_set1_epi32((static_cast<u16>(second) << 16) | static_cast<u16>(first));
+        };
+        y_v_to_r = pair(c[0], c[1]);
+        y_u_to_g = pair(c[0], 0);
+        v_u_to_g = pair(c[2], c[3]);
+        y_u_to_b = pair(c[0], c[4]);
+
+        const s32 rounding_offset = 0x18;
+        r_offset = _mm_set1_epi32(c[5] + rounding_offset);
+        g_offset = _mm_set1_epi32(c[6] + rounding_offset);
+        b_offset = _mm_set1_epi32(c[7] + rounding_offset);
+    }
+
+    __m128i y_v_to_r, y_u_to_g, v_u_to_g, y_u_to_b;
+    __m128i r_offset, g_offset, b_offset;
+};
 
-            using MathUtil::Clamp;
-            *out = ((u32)Clamp(r >> 5, 0, 0xFF) << 24) | ((u32)Clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)Clamp(b >> 5, 0, 0xFF) << 8);
+static inline __m128i LoadU32(const u8* data) {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return _mm_cvtsi32_si128(static_cast<int>(value));
+}
+
+/**
+ * Gets the YUV values of 8 consecutive pixels of an image strip in the source YUV format, as
+ * vectors of 16-bit values.
+ */
+template <InputFormat input_format>
+static void GetYUV8(const u8* input_Y, const u8* input_U, const u8* input_V, unsigned int x,
+                    unsigned int y, unsigned int width, __m128i& Y, __m128i& U, __m128i& V) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t uv_offset = 0;
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        uv_offset = (y * width + x) / 2;
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        uv_offset = ((y / 2) * width + x) / 2;
+        break;
+    case InputFormat::YUYV422_Interleaved: {
+        // Each pair of pixels is stored as Y0 U Y1 V
+        const __m128i yuyv =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(input_Y + (y * width + x) * 2));
+        Y = _mm_and_si128(yuyv, _mm_set1_epi16(0xFF));
+        const __m128i uv = _mm_srli_epi16(yuyv, 8);
+        U = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+                                _MM_SHUFFLE(2, 2, 0, 0));
+        V = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)),
+                                _MM_SHUFFLE(3, 3, 1, 1));
+        return;
+    }
+    }
+
+    // Each U and V value is shared by two horizontally adjacent pixels
+    Y = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input_Y + y * width + x)), zero);
+    const __m128i u = LoadU32(input_U + uv_offset);
+    const __m128i v = LoadU32(input_V + uv_offset);
+    U = _mm_unpacklo_epi8(_mm_unpacklo_epi8(u, u), zero);
+    V = _mm_unpacklo_epi8(_mm_unpacklo_epi8(v, v), zero);
+}
+
+/// Converts 4 pixels, given as interleaved pairs of 16-bit YUV values, to RGB components
+static inline void ConvertPixels4(__m128i y_v, __m128i y_u, __m128i v_u, const SSECoefficients& c,
+                                  __m128i& r, __m128i& g, __m128i& b) {
+    // Same calculation as ConvertPixel, the products fit in 32 bits
+    r = _mm_madd_epi16(y_v, c.y_v_to_r);
+    g = _mm_sub_epi32(_mm_madd_epi16(y_u, c.y_u_to_g), _mm_madd_epi16(v_u, c.v_u_to_g));
+    b = _mm_madd_epi16(y_u, c.y_u_to_b);
+
+    r = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(r, 3), c.r_offset), 5);
+    g = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(g, 3), c.g_offset), 5);
+    b = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(b, 3), c.b_offset), 5);
+}
+
+/// Converts 8 pixels, given as vectors of 16-bit YUV values, to RGB32
+static inline void ConvertPixels8(__m128i Y, __m128i U, __m128i V, const SSECoefficients& c,
+                                  u32* output) {
+    __m128i r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+    ConvertPixels4(_mm_unpacklo_epi16(Y, V), _mm_unpacklo_epi16(Y, U), _mm_unpacklo_epi16(V, U), c,
+                   r_lo, g_lo, b_lo);
+    ConvertPixels4(_mm_unpackhi_epi16(Y, V), _mm_unpackhi_epi16(Y, U), _mm_unpackhi_epi16(V, U), c,
+                   r_hi, g_hi, b_hi);
+
+    // Saturating to 16 bits and then to unsigned 8 bits is the same as clamping to [0, 255]
+    const __m128i r = _mm_packus_epi16(_mm_packs_epi32(r_lo, r_hi), _mm_setzero_si128());
+    const __m128i g = _mm_packus_epi16(_mm_packs_epi32(g_lo, g_hi), _mm_setzero_si128());
+    const __m128i b = _mm_packus_epi16(_mm_packs_epi32(b_lo, b_hi), _mm_setzero_si128());
+
+    const __m128i b0 = _mm_unpacklo_epi8(_mm_setzero_si128(), b);
+    const __m128i rg = _mm_unpacklo_epi8(g, r);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(b0, rg));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(b0, rg));
+}
+
+#endif
+
+/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
+template <InputFormat input_format>
+static void ConvertYUVToRGB(const u8* input_Y, const u8* input_U, const u8* input_V,
+                            ImageTile output[], unsigned int width, unsigned int height,
+                            const CoefficientSet& coefficients) {
+#ifdef ARCHITECTURE_x86_64
+    const SSECoefficients sse_coefficients(coefficients);
+#endif
+
+    // The width is a multiple of 8, so every row of every tile is converted in one go
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; x += 8) {
+            u32* out = &output[x / 8][y * 8];
+#ifdef ARCHITECTURE_x86_64
+            __m128i Y, U, V;
+            GetYUV8<input_format>(input_Y, input_U, input_V, x, y, width, Y, U, V);
+            ConvertPixels8(Y, U, V, sse_coefficients, out);
+#else
+            for (unsigned int tile_x = 0; tile_x < 8; ++tile_x) {
+                s32 Y, U, V;
+                GetYUV<input_format>(input_Y, input_U, input_V, x + tile_x, y, width, Y, U, V);
+                out[tile_x] = ConvertPixel(Y, U, V, coefficients);
+            }
+#endif
         }
     }
 }
 
+static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                            const u8* input_V, ImageTile output[], unsigned int width,
+                            unsigned int height, const CoefficientSet& coefficients) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        ConvertYUVToRGB<InputFormat::YUV422_Indiv8>(input_Y, input_U, input_V, output, width,
+                                                    height, coefficients);
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        ConvertYUVToRGB<InputFormat::YUV420_Indiv8>(input_Y, input_U, input_V, output, width,
+                                                    height, coefficients);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ConvertYUVToRGB<InputFormat::YUYV422_Interleaved>(input_Y, input_U, input_V, output,
+                                                          width, height, coefficients);
+        break;
+    }
+}
+
 /// Simulates an incoming CDMA transfer. The N parameter is used to automatically convert 16-bit
 /// formats to 8-bit.
 template <size_t N>
@@ -88,8 +237,12 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, size_t amount_of_data
     ASSERT(amount_of_data % output_unit == 0);
 
     while (amount_of_data > 0) {
-        for (size_t i = 0; i < output_unit; ++i) {
-            output[i] = input[i * N];
+        if (N == 1) {
+            std::memcpy(output, input, output_unit);
+        } else {
+            for (size_t i = 0; i < output_unit; ++i) {
+                output[i] = input[i * N];
+            }
         }
 
         output += output_unit;
@@ -103,8 +256,8 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, size_t amount_of_data
 
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
-static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
-                     OutputFormat output_format, u8 alpha) {
+template <OutputFormat output_format>
+static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data, u8 alpha) {
 
     u8* output = Memory::GetPointer(buf.address);
 
@@ -142,6 +295,24 @@ static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data
     }
 }
 
+static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
+                     OutputFormat output_format, u8 alpha) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        SendData<OutputFormat::RGBA8>(input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB8:
+        SendData<OutputFormat::RGB8>(input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB5A1:
+        SendData<OutputFormat::RGB5A1>(input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB565:
+        SendData<OutputFormat::RGB565>(input, buf, amount_of_data, alpha);
+        break;
+    }
+}
+
 static const u8 linear_lut[TILE_SIZE] = {
     // clang-format off
      0,  1,  2,  3,  4,  5,  6,  7,
@@ -168,14 +339,14 @@ static const u8 morton_lut[TILE_SIZE] = {
     // clang-format on
 };
 
-static void RotateTile0(const ImageTile& input, ImageTile& output, int height,
+static void RotateTile0(const ImageTile& input, u32 output[], int height,
                         const u8 out_map[64]) {
     for (int i = 0; i < height * 8; ++i) {
         output[out_map[i]] = input[i];
     }
 }
 
-static void RotateTile90(const ImageTile& input, ImageTile& output, int height,
+static void RotateTile90(const ImageTile& input, u32 output[], int height,
                          const u8 out_map[64]) {
     int out_i = 0;
     for (int x = 0; x < 8; ++x) {
@@ -185,7 +356,7 @@ static void RotateTile90(const ImageTile& input, ImageTile& output, int height,
     }
 }
 
-static void RotateTile180(const ImageTile& input, ImageTile& output, int height,
+static void RotateTile180(const ImageTile& input, u32 output[], int height,
                           const u8 out_map[64]) {
     int out_i = 0;
     for (int i = height * 8 - 1; i >= 0; --i) {
@@ -193,7 +364,7 @@ static void RotateTile180(const ImageTile& input, ImageTile& output, int height,
     }
 }
 
-static void RotateTile270(const ImageTile& input, ImageTile& output, int height,
+static void RotateTile270(const ImageTile& input, u32 output[], int height,
                           const u8 out_map[64]) {
     int out_i = 0;
     for (int x = 8 - 1; x >= 0; --x) {
@@ -205,12 +376,71 @@ static void RotateTile270(const ImageTile& input, ImageTile& output, int height,
 
 static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
     for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            output[y * line_stride + x] = tile[y * 8 + x];
+        std::memcpy(&output[y * line_stride], &tile[y * 8], 8 * sizeof(u32));
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+/// Transposes a 4x4 block of 32-bit values, given as its rows
+static inline void Transpose4x4(__m128i& row0, __m128i& row1, __m128i& row2, __m128i& row3) {
+    const __m128i t0 = _mm_unpacklo_epi32(row0, row1);
+    const __m128i t1 = _mm_unpacklo_epi32(row2, row3);
+    const __m128i t2 = _mm_unpackhi_epi32(row0, row1);
+    const __m128i t3 = _mm_unpackhi_epi32(row2, row3);
+    row0 = _mm_unpacklo_epi64(t0, t1);
+    row1 = _mm_unpackhi_epi64(t0, t1);
+    row2 = _mm_unpacklo_epi64(t2, t3);
+    row3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+/**
+ * Transposes a full tile into a linear 8x8 block, in 4x4 blocks. Reversing the order of the input
+ * rows turns this into a 90 degree rotation, reversing the order of the output rows into a 270
+ * degree one.
+ */
+template <bool reverse_input_rows, bool reverse_output_rows>
+static void TransposeTileToOutput(u32* output, const ImageTile& tile) {
+    const auto load = [&tile](int y, int x) {
+        y = reverse_input_rows ? 7 - y : y;
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(&tile[y * 8 + x]));
+    };
+    const auto store = [output](int y, int x, __m128i row) {
+        y = reverse_output_rows ? 7 - y : y;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[y * 8 + x]), row);
+    };
+
+    for (int block_y = 0; block_y < 8; block_y += 4) {
+        for (int block_x = 0; block_x < 8; block_x += 4) {
+            __m128i row0 = load(block_y, block_x);
+            __m128i row1 = load(block_y + 1, block_x);
+            __m128i row2 = load(block_y + 2, block_x);
+            __m128i row3 = load(block_y + 3, block_x);
+            Transpose4x4(row0, row1, row2, row3);
+            store(block_x, block_y, row0);
+            store(block_x + 1, block_y, row1);
+            store(block_x + 2, block_y, row2);
+            store(block_x + 3, block_y, row3);
         }
     }
 }
 
+/// Writes a tile rotated by 180 degrees to a linear output strip
+static void ReverseTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
+    for (int y = 0; y < height; ++y) {
+        const u32* row = &tile[(height - 1 - y) * 8];
+        const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+        const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 4));
+        u32* out = &output[y * line_stride];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                         _mm_shuffle_epi32(right, _MM_SHUFFLE(0, 1, 2, 3)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4),
+                         _mm_shuffle_epi32(left, _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+}
+
+#endif
+
 /**
  * Performs a Y2R colorspace conversion.
  *
@@ -324,37 +554,70 @@ void PerformConversion(ConversionConfiguration& cvt) {
             break;
         }
 
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
         ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
                         cvt.input_line_width, row_height, cvt.coefficients);
 
         u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
 
         for (size_t i = 0; i < num_tiles; ++i) {
+            // Linear output doesn't remap the tiles, so the common rotations are written straight
+            // to the output
+            if (cvt.rotation == Rotation::None && cvt.block_alignment == BlockAlignment::Linear) {
+                WriteTileToOutput(output_buffer, tiles[i], row_height, cvt.input_line_width);
+                output_buffer += 8;
+                continue;
+            }
+
+#ifdef ARCHITECTURE_x86_64
+            if (cvt.block_alignment == BlockAlignment::Linear) {
+                if (cvt.rotation == Rotation::Clockwise_180) {
+                    ReverseTileToOutput(output_buffer, tiles[num_tiles - i - 1], row_height,
+                                        cvt.input_line_width);
+                    output_buffer += 8;
+                    continue;
+                }
+
+                // A full tile rotated by 90 or 270 degrees is written out as an 8x8 block
+                if (row_height == 8 && cvt.rotation == Rotation::Clockwise_90) {
+                    TransposeTileToOutput<true, false>(output_buffer, tiles[i]);
+                    output_buffer += TILE_SIZE;
+                    continue;
+                }
+                if (row_height == 8 && cvt.rotation == Rotation::Clockwise_270) {
+                    TransposeTileToOutput<false, true>(output_buffer, tiles[num_tiles - i - 1]);
+                    output_buffer += TILE_SIZE;
+                    continue;
+                }
+            }
+#endif
+
+            // 8x8 blocks are contiguous in the output, so they are rotated straight into it
+            u32* rotated_tile = cvt.block_alignment == BlockAlignment::Block8x8
+                                    ? output_buffer
+                                    : tmp_tile.data();
             int image_strip_width = 0;
             int output_stride = 0;
 
             switch (cvt.rotation) {
             case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
+                RotateTile0(tiles[i], rotated_tile, row_height, tile_remap);
                 image_strip_width = cvt.input_line_width;
                 output_stride = 8;
                 break;
             case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
+                RotateTile90(tiles[i], rotated_tile, row_height, tile_remap);
                 image_strip_width = 8;
                 output_stride = 8 * row_height;
                 break;
             case Rotation::Clockwise_180:
                 // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
                 // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+                RotateTile180(tiles[num_tiles - i - 1], rotated_tile, row_height, tile_remap);
                 image_strip_width = cvt.input_line_width;
                 output_stride = 8;
                 break;
             case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+                RotateTile270(tiles[num_tiles - i - 1], rotated_tile, row_height, tile_remap);
                 image_strip_width = 8;
                 output_stride = 8 * row_height;
                 break;
@@ -366,14 +629,11 @@ void PerformConversion(ConversionConfiguration& cvt) {
                 output_buffer += output_stride;
                 break;
             case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
                 output_buffer += TILE_SIZE;
                 break;
             }
         }
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
         SendData(reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
                  cvt.output_format, (u8)cvt.alpha);
     }
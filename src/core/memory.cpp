@@ -275,6 +275,13 @@ std::string ReadCString(VAddr vaddr, std::size_t max_length) {
 }
 
 u8* GetPhysicalPointer(PAddr address) {
+    u32 contiguous_size;
+    return GetPhysicalPointer(address, contiguous_size);
+}
+
+u8* GetPhysicalPointer(PAddr address, u32& contiguous_size) {
+    contiguous_size = 0;
+
     struct MemoryArea {
         PAddr paddr_base;
         u32 size;
@@ -309,16 +316,20 @@ u8* GetPhysicalPointer(PAddr address) {
     switch (area->paddr_base) {
     case VRAM_PADDR:
         target_pointer = vram.data() + offset_into_region;
+        contiguous_size = area->size - offset_into_region;
         break;
     case DSP_RAM_PADDR:
         target_pointer = AudioCore::GetDspMemory().data() + offset_into_region;
+        contiguous_size = area->size - offset_into_region;
         break;
     case FCRAM_PADDR:
+        // Each memory region is backed by its own heap, so accesses can't cross region boundaries
         for (const auto& region : Kernel::memory_regions) {
             if (offset_into_region >= region.base &&
                 offset_into_region < region.base + region.size) {
                 target_pointer =
                     region.linear_heap_memory->data() + offset_into_region - region.base;
+                contiguous_size = region.base + region.size - offset_into_region;
                 break;
             }
         }
@@ -326,6 +337,7 @@ u8* GetPhysicalPointer(PAddr address) {
         break;
     case N3DS_EXTRA_RAM_PADDR:
         target_pointer = n3ds_extra_ram.data() + offset_into_region;
+        contiguous_size = area->size - offset_into_region;
         break;
     default:
         UNREACHABLE();
@@ -462,6 +474,78 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
     }
 }
 
+/// A run of consecutive pages of the same type that can be accessed with a single operation.
+struct MemorySpan {
+    PageType type;
+    /// Number of bytes in the span, starting at the address it was resolved for.
+    size_t size;
+    /// Host memory backing the span. Only valid for Memory and RasterizerCachedMemory spans.
+    u8* host_pointer;
+    /// Handler of the span. Only valid for Special and RasterizerCachedSpecial spans.
+    MMIORegionPointer mmio_handler;
+};
+
+/**
+ * Resolves the longest span of at most `max_size` bytes starting at `vaddr`. Memory pages are
+ * merged as long as their host memory is contiguous, IO pages as long as they belong to the same
+ * MMIO handler, and unmapped pages as long as they stay unmapped. This lets the block functions
+ * below do one memcpy and one rasterizer flush per span instead of one per page.
+ */
+static MemorySpan ResolveSpan(const Kernel::Process& process, const VAddr vaddr,
+                              const size_t max_size) {
+    const PageTable& page_table = process.vm_manager.page_table;
+    const PageType type = page_table.attributes[vaddr >> PAGE_BITS];
+    MemorySpan span{type, 0, nullptr, nullptr};
+
+    // End of the VMA backing a RasterizerCachedMemory span, within which host memory is contiguous
+    u64 vma_end = 0;
+
+    switch (type) {
+    case PageType::Unmapped:
+        break;
+    case PageType::Memory:
+        DEBUG_ASSERT(page_table.pointers[vaddr >> PAGE_BITS]);
+        span.host_pointer = page_table.pointers[vaddr >> PAGE_BITS] + (vaddr & PAGE_MASK);
+        break;
+    case PageType::RasterizerCachedMemory: {
+        const auto& vma = process.vm_manager.FindVMA(vaddr)->second;
+        vma_end = u64(vma.base) + vma.size;
+        span.host_pointer = GetPointerFromVMA(process, vaddr);
+        break;
+    }
+    case PageType::Special:
+    case PageType::RasterizerCachedSpecial:
+        span.mmio_handler = GetMMIOHandler(page_table, vaddr);
+        DEBUG_ASSERT(span.mmio_handler);
+        break;
+    default:
+        UNREACHABLE();
+    }
+
+    span.size = std::min<size_t>(PAGE_SIZE - (vaddr & PAGE_MASK), max_size);
+    while (span.size < max_size) {
+        const u64 next_vaddr = u64(vaddr) + span.size;
+        if (next_vaddr > 0xFFFFFFFF)
+            break;
+
+        const size_t next_page_index = static_cast<size_t>(next_vaddr >> PAGE_BITS);
+        if (page_table.attributes[next_page_index] != type)
+            break;
+        if (type == PageType::Memory &&
+            page_table.pointers[next_page_index] != span.host_pointer + span.size)
+            break;
+        if (type == PageType::RasterizerCachedMemory && next_vaddr >= vma_end)
+            break;
+        if ((type == PageType::Special || type == PageType::RasterizerCachedSpecial) &&
+            GetMMIOHandler(page_table, static_cast<VAddr>(next_vaddr)) != span.mmio_handler)
+            break;
+
+        span.size += std::min<size_t>(PAGE_SIZE, max_size - span.size);
+    }
+
+    return span;
+}
+
 u8 Read8(const VAddr addr) {
     return Read<u8>(addr);
 }
@@ -480,58 +564,47 @@ u64 Read64(const VAddr addr) {
 
 void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
                const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
-
     size_t remaining_size = size;
-    size_t page_index = src_addr >> PAGE_BITS;
-    size_t page_offset = src_addr & PAGE_MASK;
+    VAddr current_vaddr = src_addr;
+    u8* dest_ptr = static_cast<u8*>(dest_buffer);
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const MemorySpan span = ResolveSpan(process, current_vaddr, remaining_size);
 
-        switch (page_table.attributes[page_index]) {
+        switch (span.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory, "unmapped ReadBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, src_addr, size);
-            std::memset(dest_buffer, 0, copy_amount);
+            std::memset(dest_ptr, 0, span.size);
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-            std::memcpy(dest_buffer, src_ptr, copy_amount);
+            std::memcpy(dest_ptr, span.host_pointer, span.size);
             break;
         }
         case PageType::Special: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            handler->ReadBlock(current_vaddr, dest_buffer, copy_amount);
+            span.mmio_handler->ReadBlock(current_vaddr, dest_ptr, span.size);
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
                                          FlushMode::Flush);
-            std::memcpy(dest_buffer, GetPointerFromVMA(process, current_vaddr), copy_amount);
+            std::memcpy(dest_ptr, span.host_pointer, span.size);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
                                          FlushMode::Flush);
-            handler->ReadBlock(current_vaddr, dest_buffer, copy_amount);
+            span.mmio_handler->ReadBlock(current_vaddr, dest_ptr, span.size);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
-        dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
-        remaining_size -= copy_amount;
+        current_vaddr += static_cast<VAddr>(span.size);
+        dest_ptr += span.size;
+        remaining_size -= span.size;
     }
 }
 
@@ -557,16 +630,14 @@ void Write64(const VAddr addr, const u64 data) {
 
 void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const void* src_buffer,
                 const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
     size_t remaining_size = size;
-    size_t page_index = dest_addr >> PAGE_BITS;
-    size_t page_offset = dest_addr & PAGE_MASK;
+    VAddr current_vaddr = dest_addr;
+    const u8* src_ptr = static_cast<const u8*>(src_buffer);
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const MemorySpan span = ResolveSpan(process, current_vaddr, remaining_size);
 
-        switch (page_table.attributes[page_index]) {
+        switch (span.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "unmapped WriteBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
@@ -574,40 +645,32 @@ void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const voi
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-            std::memcpy(dest_ptr, src_buffer, copy_amount);
+            std::memcpy(span.host_pointer, src_ptr, span.size);
             break;
         }
         case PageType::Special: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            handler->WriteBlock(current_vaddr, src_buffer, copy_amount);
+            span.mmio_handler->WriteBlock(current_vaddr, src_ptr, span.size);
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
                                          FlushMode::FlushAndInvalidate);
-            std::memcpy(GetPointerFromVMA(process, current_vaddr), src_buffer, copy_amount);
+            std::memcpy(span.host_pointer, src_ptr, span.size);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
                                          FlushMode::FlushAndInvalidate);
-            handler->WriteBlock(current_vaddr, src_buffer, copy_amount);
+            span.mmio_handler->WriteBlock(current_vaddr, src_ptr, span.size);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
-        src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
-        remaining_size -= copy_amount;
+        current_vaddr += static_cast<VAddr>(span.size);
+        src_ptr += span.size;
+        remaining_size -= span.size;
     }
 }
 
@@ -615,58 +678,85 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
     WriteBlock(*Kernel::g_current_process, dest_addr, src_buffer, size);
 }
 
+bool GetHostRegions(const Kernel::Process& process, const VAddr vaddr, const size_t size,
+                    const FlushMode mode, std::vector<HostRegion>& regions) {
+    regions.clear();
+
+    size_t remaining_size = size;
+    VAddr current_vaddr = vaddr;
+
+    while (remaining_size > 0) {
+        const MemorySpan span = ResolveSpan(process, current_vaddr, remaining_size);
+
+        switch (span.type) {
+        case PageType::Memory:
+            break;
+        case PageType::RasterizerCachedMemory:
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size), mode);
+            break;
+        default:
+            return false;
+        }
+
+        // Consecutive spans may still be contiguous in host memory, e.g. when only the page type
+        // changed between them
+        if (!regions.empty() && regions.back().pointer + regions.back().size == span.host_pointer) {
+            regions.back().size += span.size;
+        } else {
+            regions.push_back(HostRegion{span.host_pointer, span.size});
+        }
+
+        current_vaddr += static_cast<VAddr>(span.size);
+        remaining_size -= span.size;
+    }
+
+    return true;
+}
+
 void ZeroBlock(const Kernel::Process& process, const VAddr dest_addr, const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
     size_t remaining_size = size;
-    size_t page_index = dest_addr >> PAGE_BITS;
-    size_t page_offset = dest_addr & PAGE_MASK;
+    VAddr current_vaddr = dest_addr;
 
     static const std::array<u8, PAGE_SIZE> zeros = {};
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const MemorySpan span = ResolveSpan(process, current_vaddr, remaining_size);
 
-        switch (page_table.attributes[page_index]) {
+        switch (span.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory, "unmapped ZeroBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, dest_addr, size);
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-            std::memset(dest_ptr, 0, copy_amount);
+            std::memset(span.host_pointer, 0, span.size);
             break;
         }
-        case PageType::Special: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            handler->WriteBlock(current_vaddr, zeros.data(), copy_amount);
+        case PageType::Special:
+        case PageType::RasterizerCachedSpecial: {
+            if (span.type == PageType::RasterizerCachedSpecial) {
+                RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
+                                             FlushMode::FlushAndInvalidate);
+            }
+            for (size_t offset = 0; offset < span.size; offset += zeros.size()) {
+                const size_t write_amount = std::min(zeros.size(), span.size - offset);
+                span.mmio_handler->WriteBlock(current_vaddr + static_cast<VAddr>(offset),
+                                              zeros.data(), write_amount);
+            }
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::FlushAndInvalidate);
-            std::memset(GetPointerFromVMA(process, current_vaddr), 0, copy_amount);
-            break;
-        }
-        case PageType::RasterizerCachedSpecial: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
                                          FlushMode::FlushAndInvalidate);
-            handler->WriteBlock(current_vaddr, zeros.data(), copy_amount);
+            std::memset(span.host_pointer, 0, span.size);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
-        remaining_size -= copy_amount;
+        current_vaddr += static_cast<VAddr>(span.size);
+        remaining_size -= span.size;
     }
 }
 
@@ -675,50 +765,41 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
 }
 
 void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr, const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
     size_t remaining_size = size;
-    size_t page_index = src_addr >> PAGE_BITS;
-    size_t page_offset = src_addr & PAGE_MASK;
+    VAddr current_vaddr = src_addr;
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const MemorySpan span = ResolveSpan(process, current_vaddr, remaining_size);
 
-        switch (page_table.attributes[page_index]) {
+        switch (span.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory, "unmapped CopyBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, src_addr, size);
-            ZeroBlock(process, dest_addr, copy_amount);
+            ZeroBlock(process, dest_addr, span.size);
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-            WriteBlock(process, dest_addr, src_ptr, copy_amount);
+            WriteBlock(process, dest_addr, span.host_pointer, span.size);
             break;
         }
         case PageType::Special: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            std::vector<u8> buffer(copy_amount);
-            handler->ReadBlock(current_vaddr, buffer.data(), buffer.size());
+            std::vector<u8> buffer(span.size);
+            span.mmio_handler->ReadBlock(current_vaddr, buffer.data(), buffer.size());
             WriteBlock(process, dest_addr, buffer.data(), buffer.size());
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
                                          FlushMode::Flush);
-            WriteBlock(process, dest_addr, GetPointerFromVMA(process, current_vaddr), copy_amount);
+            WriteBlock(process, dest_addr, span.host_pointer, span.size);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
-            MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span.size),
                                          FlushMode::Flush);
 
-            std::vector<u8> buffer(copy_amount);
-            handler->ReadBlock(current_vaddr, buffer.data(), buffer.size());
+            std::vector<u8> buffer(span.size);
+            span.mmio_handler->ReadBlock(current_vaddr, buffer.data(), buffer.size());
             WriteBlock(process, dest_addr, buffer.data(), buffer.size());
             break;
         }
@@ -726,11 +807,9 @@ void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr,
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
-        dest_addr += static_cast<VAddr>(copy_amount);
-        src_addr += static_cast<VAddr>(copy_amount);
-        remaining_size -= copy_amount;
+        dest_addr += static_cast<VAddr>(span.size);
+        current_vaddr += static_cast<VAddr>(span.size);
+        remaining_size -= span.size;
     }
 }
 
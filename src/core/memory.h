@@ -244,6 +244,13 @@ boost::optional<VAddr> PhysicalToVirtualAddress(PAddr addr);
  */
 u8* GetPhysicalPointer(PAddr address);
 
+/**
+ * Gets a pointer to the memory region beginning at the specified physical address.
+ * @param contiguous_size Receives the number of bytes that can be accessed through the pointer, or
+ *                        0 if the address is invalid
+ */
+u8* GetPhysicalPointer(PAddr address, u32& contiguous_size);
+
 /**
  * Adds the supplied value to the rasterizer resource cache counter of each
  * page touching the region.
@@ -273,4 +280,22 @@ enum class FlushMode {
  */
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode);
 
+/// A block of host memory backing part of a guest virtual memory range.
+struct HostRegion {
+    u8* pointer;
+    size_t size;
+};
+
+/**
+ * Resolves the host memory backing the given virtual memory range of a process, so that it can be
+ * accessed directly instead of going through ReadBlock/WriteBlock and a temporary buffer. Pages
+ * whose host memory is contiguous are merged into a single region. Rasterizer cached pages are
+ * flushed according to `mode` beforehand, like the block functions do.
+ * @param regions Receives the regions, in the order of the virtual addresses they back
+ * @return false if part of the range is unmapped or IO memory, in which case it has to be
+ *         accessed through the block functions instead
+ */
+bool GetHostRegions(const Kernel::Process& process, VAddr vaddr, size_t size, FlushMode mode,
+                    std::vector<HostRegion>& regions);
+
 } // namespace Memory
@@ -22,6 +22,9 @@ void Apply() {
 
     VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
+    VideoCore::g_vertex_loader_jit_enabled = values.use_vertex_loader_jit;
+    VideoCore::g_parallel_vertex_threshold = values.parallel_vertex_threshold;
+    VideoCore::g_vertex_cache_size = values.vertex_cache_size;
     VideoCore::g_toggle_framelimit_enabled = values.toggle_framelimit;
 
     if (VideoCore::g_emu_window) {
@@ -88,6 +88,7 @@ struct Values {
 
     // Data Storage
     bool use_virtual_sd;
+    bool cache_file_writes;
 
     // System Region
     int region_value;
@@ -95,6 +96,9 @@ struct Values {
     // Renderer
     bool use_hw_renderer;
     bool use_shader_jit;
+    bool use_vertex_loader_jit;
+    u32 parallel_vertex_threshold;
+    u32 vertex_cache_size;
     float resolution_factor;
     bool use_vsync;
     bool toggle_framelimit;
@@ -0,0 +1,58 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+
+namespace FileUtil {
+
+TEST_CASE("MappedFile", "[common]") {
+    const std::string path = "mapped_file_test.bin";
+    std::vector<u8> contents(3 * 0x10000 + 0x123);
+    for (size_t i = 0; i < contents.size(); ++i) {
+        contents[i] = static_cast<u8>(i * 13);
+    }
+    {
+        IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes(contents.data(), contents.size()) == contents.size());
+    }
+
+    IOFile file(path, "rb");
+    REQUIRE(file.IsOpen());
+
+    SECTION("offsets don't need to be aligned") {
+        const u64 offset = 0x10000 + 0x45;
+        const u64 size = 0x20000;
+        MappedFile mapping(file, offset, size);
+        REQUIRE(mapping.IsOpen());
+        CHECK(mapping.GetSize() == size);
+        CHECK(std::memcmp(mapping.GetData(), contents.data() + offset, size) == 0);
+
+        mapping.Advise(MappedFile::AccessPattern::Sequential);
+        mapping.Prefetch(0x100, 0x1000);
+        mapping.Prefetch(size - 1, 0x1000);
+    }
+
+    SECTION("the mapping outlives the file and can be moved") {
+        MappedFile mapping(file, 0, contents.size());
+        file.Close();
+        MappedFile moved(std::move(mapping));
+        CHECK_FALSE(mapping.IsOpen());
+        REQUIRE(moved.IsOpen());
+        CHECK(std::memcmp(moved.GetData(), contents.data(), contents.size()) == 0);
+    }
+
+    SECTION("ranges past the end of the file can't be mapped") {
+        MappedFile mapping(file, contents.size() - 0x10, 0x20);
+        CHECK_FALSE(mapping.IsOpen());
+    }
+
+    file.Close();
+    Delete(path);
+}
+
+} // namespace FileUtil
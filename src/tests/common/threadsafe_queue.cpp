@@ -0,0 +1,148 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+TEST_CASE("BoundedMPSCQueue: Full queue", "[common]") {
+    BoundedMPSCQueue<int, 4> queue;
+    int value;
+
+    REQUIRE(queue.Empty());
+    REQUIRE(!queue.Pop(value));
+
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.TryPush(i));
+    }
+    REQUIRE(!queue.TryPush(4));
+
+    // Elements come out in order, and popping one makes room for another
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(queue.TryPush(4));
+    REQUIRE(!queue.TryPush(5));
+
+    for (int i = 1; i <= 4; ++i) {
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(queue.Empty());
+    REQUIRE(!queue.Pop(value));
+}
+
+TEST_CASE("BoundedMPSCQueue: PopClaimed", "[common]") {
+    BoundedMPSCQueue<int, 4> queue;
+    int value;
+
+    REQUIRE(!queue.PopClaimed(value));
+    REQUIRE(queue.TryPush(1));
+    REQUIRE(queue.TryPush(2));
+    REQUIRE(queue.PopClaimed(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 2);
+    REQUIRE(!queue.PopClaimed(value));
+}
+
+TEST_CASE("BoundedMPSCQueue: Multiple producers", "[common]") {
+    constexpr u32 NUM_PRODUCERS = 4;
+    constexpr u32 NUM_ELEMENTS = 100000;
+    BoundedMPSCQueue<u64, 256> queue;
+
+    // Each producer pushes its own increasing sequence, retrying whenever the queue is full
+    std::vector<std::thread> producers;
+    for (u32 producer = 0; producer < NUM_PRODUCERS; ++producer) {
+        producers.emplace_back([&queue, producer] {
+            for (u32 i = 0; i < NUM_ELEMENTS; ++i) {
+                const u64 element = (static_cast<u64>(producer) << 32) | i;
+                while (!queue.TryPush(element))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // Every element must arrive exactly once, in the order it was pushed by its producer
+    std::array<u32, NUM_PRODUCERS> next{};
+    u32 received = 0;
+    bool in_order = true;
+    while (received < NUM_PRODUCERS * NUM_ELEMENTS) {
+        u64 element;
+        if (!queue.Pop(element)) {
+            std::this_thread::yield();
+            continue;
+        }
+        const u32 producer = static_cast<u32>(element >> 32);
+        in_order &= producer < NUM_PRODUCERS && static_cast<u32>(element) == next[producer];
+        if (producer < NUM_PRODUCERS)
+            next[producer]++;
+        received++;
+    }
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    REQUIRE(in_order);
+    REQUIRE(queue.Empty());
+    for (u32 count : next) {
+        REQUIRE(count == NUM_ELEMENTS);
+    }
+}
+
+/// Returns the time per element for num_producers threads pushing to one consumer thread
+template <typename Queue, typename PushFunction>
+static double TimeProducers(u32 num_producers, PushFunction push) {
+    constexpr u32 NUM_ELEMENTS = 200000;
+    Queue queue;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (u32 producer = 0; producer < num_producers; ++producer) {
+        producers.emplace_back([&queue, push] {
+            for (u32 i = 0; i < NUM_ELEMENTS; ++i) {
+                push(queue, i);
+            }
+        });
+    }
+
+    u64 element;
+    for (u32 received = 0; received < num_producers * NUM_ELEMENTS;) {
+        if (queue.Pop(element)) {
+            received++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    return elapsed.count() / (num_producers * NUM_ELEMENTS);
+}
+
+TEST_CASE("BoundedMPSCQueue: Multiple producers benchmark", "[.][benchmark]") {
+    for (u32 num_producers : {1, 2, 4, 8}) {
+        const double bounded = TimeProducers<BoundedMPSCQueue<u64, 512>>(
+            num_producers, [](BoundedMPSCQueue<u64, 512>& queue, u64 element) {
+                while (!queue.TryPush(element))
+                    std::this_thread::yield();
+            });
+        const double locked = TimeProducers<MPSCQueue<u64, false>>(
+            num_producers, [](MPSCQueue<u64, false>& queue, u64 element) { queue.Push(element); });
+        std::printf("%u producers: %.1f ns per element with BoundedMPSCQueue, %.1f ns with "
+                    "MPSCQueue\n",
+                    num_producers, bounded, locked);
+    }
+}
+
+} // namespace Common
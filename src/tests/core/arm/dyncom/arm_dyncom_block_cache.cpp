@@ -0,0 +1,171 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <catch.hpp>
+
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+#include "core/arm/dyncom/arm_dyncom_trans.h"
+
+TEST_CASE("BlockCache: Insert and Find", "[arm_dyncom]") {
+    BlockCache cache;
+
+    REQUIRE(cache.Find(0x00100000) == BlockCache::INVALID_OFFSET);
+
+    cache.Insert(0x00100000, 0x40);
+    cache.Insert(0x00100002, 0x80); // Thumb PCs are halfword aligned
+    cache.Insert(0xFFFFFFFE, 0xC0);
+
+    REQUIRE(cache.Find(0x00100000) == 0x40);
+    REQUIRE(cache.Find(0x00100002) == 0x80);
+    REQUIRE(cache.Find(0x00100004) == BlockCache::INVALID_OFFSET);
+    REQUIRE(cache.Find(0xFFFFFFFE) == 0xC0);
+}
+
+TEST_CASE("BlockCache: InvalidateRange only drops overlapping pages", "[arm_dyncom]") {
+    BlockCache cache;
+
+    cache.Insert(0x00100000, 0x10);
+    cache.Insert(0x00101FFC, 0x20);
+    cache.Insert(0x00102000, 0x30);
+
+    cache.InvalidateRange(0x00101FF0, 4);
+    REQUIRE(cache.Find(0x00100000) == 0x10);
+    REQUIRE(cache.Find(0x00101FFC) == BlockCache::INVALID_OFFSET);
+    REQUIRE(cache.Find(0x00102000) == 0x30);
+
+    // Ranges that straddle a page boundary drop both pages
+    cache.InvalidateRange(0x00100FFE, 4);
+    REQUIRE(cache.Find(0x00100000) == BlockCache::INVALID_OFFSET);
+    REQUIRE(cache.Find(0x00102000) == 0x30);
+
+    // Ranges reaching the end of the address space must not wrap around
+    cache.Insert(0x00000000, 0x50);
+    cache.Insert(0xFFFFF000, 0x60);
+    cache.InvalidateRange(0xFFFFF000, 0x2000);
+    REQUIRE(cache.Find(0x00000000) == 0x50);
+    REQUIRE(cache.Find(0xFFFFF000) == BlockCache::INVALID_OFFSET);
+}
+
+TEST_CASE("BlockCache: Clear", "[arm_dyncom]") {
+    BlockCache cache;
+
+    cache.Insert(0x00100000, 0x10);
+    cache.Insert(0x08000000, 0x20);
+    cache.Clear();
+
+    REQUIRE(cache.Find(0x00100000) == BlockCache::INVALID_OFFSET);
+    REQUIRE(cache.Find(0x08000000) == BlockCache::INVALID_OFFSET);
+
+    cache.Insert(0x00100000, 0x30);
+    REQUIRE(cache.Find(0x00100000) == 0x30);
+}
+
+TEST_CASE("BlockCache: Links are reset when their target page is invalidated", "[arm_dyncom]") {
+    BlockCache cache;
+
+    std::size_t link_into_first_page = 0x10;
+    std::size_t link_into_second_page = 0x20;
+    cache.Insert(0x00100000, 0x10);
+    cache.Insert(0x00101000, 0x20);
+    cache.AddLink(0x00100000, &link_into_first_page);
+    cache.AddLink(0x00101000, &link_into_second_page);
+
+    cache.InvalidateRange(0x00101000, 0x1000);
+    REQUIRE(link_into_first_page == 0x10);
+    REQUIRE(link_into_second_page == BlockCache::INVALID_OFFSET);
+
+    // Clearing the whole cache discards the blocks holding the links, so they are left alone
+    cache.Clear();
+    cache.InvalidateRange(0x00100000, 0x1000);
+    REQUIRE(link_into_first_page == 0x10);
+}
+
+TEST_CASE("BlockCache: Full regions are recycled coldest first", "[arm_dyncom]") {
+    BlockCache cache;
+    cache.Clear();
+
+    // Translate one block into every region, filling each one up
+    for (std::size_t i = 0; i < BlockCache::NUM_REGIONS; ++i) {
+        REQUIRE(!cache.ReserveBlockSpace());
+        REQUIRE(trans_cache_buf_top == i * BlockCache::REGION_SIZE);
+        cache.Insert(static_cast<u32>(i * Memory::PAGE_SIZE), trans_cache_buf_top);
+        trans_cache_buf_top = (i + 1) * BlockCache::REGION_SIZE;
+    }
+
+    // A branch in region 1 linked to region 2, and one from elsewhere linked to region 1
+    std::size_t* link_in_region_1 =
+        reinterpret_cast<std::size_t*>(&trans_cache_buf[BlockCache::REGION_SIZE + 16]);
+    *link_in_region_1 = 2 * BlockCache::REGION_SIZE;
+    cache.AddLink(2 * Memory::PAGE_SIZE, link_in_region_1);
+    std::size_t link_into_region_1 = BlockCache::REGION_SIZE;
+    cache.AddLink(1 * Memory::PAGE_SIZE, &link_into_region_1);
+
+    // Region 0 was entered recently, so region 1 goes first
+    cache.Touch(0);
+    REQUIRE(cache.ReserveBlockSpace());
+    REQUIRE(trans_cache_buf_top == BlockCache::REGION_SIZE);
+    REQUIRE(cache.Find(0 * Memory::PAGE_SIZE) == 0);
+    REQUIRE(cache.Find(1 * Memory::PAGE_SIZE) == BlockCache::INVALID_OFFSET);
+    REQUIRE(cache.Find(2 * Memory::PAGE_SIZE) == 2 * BlockCache::REGION_SIZE);
+    REQUIRE(link_into_region_1 == BlockCache::INVALID_OFFSET);
+
+    // The evicted link must not be touched again once its memory is reused
+    *link_in_region_1 = 0x1234;
+    cache.InvalidateRange(2 * Memory::PAGE_SIZE, Memory::PAGE_SIZE);
+    REQUIRE(*link_in_region_1 == 0x1234);
+
+    const BlockCache::Stats stats = cache.GetStats();
+    REQUIRE(stats.evicted_regions == 1);
+    REQUIRE(stats.evicted_blocks == 1);
+    REQUIRE(stats.occupied_bytes == (BlockCache::NUM_REGIONS - 1) * BlockCache::REGION_SIZE);
+
+    cache.Clear();
+}
+
+TEST_CASE("BlockCache: Dispatch benchmark", "[.][benchmark]") {
+    // A working set of 4096 blocks spread over 256 pages of code, entered in a random order. The
+    // hash map is the lookup the interpreter did before the block table.
+    constexpr std::size_t num_blocks = 4096;
+    constexpr std::size_t num_lookups = 16 * 1024 * 1024;
+
+    std::mt19937 rng(1234);
+    std::vector<u32> block_pcs(num_blocks);
+    for (std::size_t i = 0; i < num_blocks; ++i) {
+        block_pcs[i] = 0x00100000 + static_cast<u32>(i / 16) * Memory::PAGE_SIZE +
+                       static_cast<u32>(rng() % (Memory::PAGE_SIZE / 4)) * 4;
+    }
+    std::vector<u32> sequence(num_lookups);
+    for (u32& pc : sequence) {
+        pc = block_pcs[rng() % num_blocks];
+    }
+
+    std::unordered_map<u32, std::size_t> hash_map;
+    BlockCache cache;
+    for (std::size_t i = 0; i < num_blocks; ++i) {
+        hash_map[block_pcs[i]] = i * 0x100;
+        cache.Insert(block_pcs[i], i * 0x100);
+    }
+
+    auto time_lookups = [&](const char* name, auto&& find) {
+        std::size_t checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (u32 pc : sequence) {
+            checksum += find(pc);
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::printf("%s: %.2f ns per dispatch (checksum %zx)\n", name,
+                    elapsed.count() / num_lookups, checksum);
+    };
+
+    time_lookups("unordered_map", [&](u32 pc) { return hash_map.find(pc)->second; });
+    time_lookups("BlockCache", [&](u32 pc) { return cache.Find(pc); });
+
+    cache.Clear();
+}
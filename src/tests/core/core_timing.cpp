@@ -5,8 +5,14 @@
 #include <catch.hpp>
 
 #include <array>
+#include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <chrono>
+#include <cstdio>
 #include <string>
+#include <thread>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -235,3 +241,251 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
 }
+
+TEST_CASE("CoreTiming[SkipIdleLoop]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    CoreTiming::ScheduleEvent(1000, cb_a, CB_IDS[0]);
+    REQUIRE(1000 == CoreTiming::GetDowncount());
+
+    // Pretend the CPU ran 300 cycles and then found itself in an idle loop
+    CoreTiming::AddTicks(300);
+    CoreTiming::SkipIdleLoop();
+    REQUIRE(0 == CoreTiming::GetDowncount());
+    REQUIRE(1 == CoreTiming::GetIdleLoopSkips());
+    REQUIRE(700 == CoreTiming::GetIdleLoopSkippedTicks());
+    REQUIRE(700 == CoreTiming::GetIdleTicks());
+
+    // The event fires on time, as if the loop had been executed
+    AdvanceAndCheck(0, MAX_SLICE_LENGTH);
+    REQUIRE(1000 == CoreTiming::GetTicks());
+
+    // Plain idling is not counted as a skipped idle loop
+    CoreTiming::Idle();
+    REQUIRE(1 == CoreTiming::GetIdleLoopSkips());
+    REQUIRE(700 == CoreTiming::GetIdleLoopSkippedTicks());
+    REQUIRE(700 + MAX_SLICE_LENGTH == CoreTiming::GetIdleTicks());
+}
+
+namespace StressTest {
+struct Fired {
+    s64 time;
+    u64 userdata;
+};
+static std::vector<Fired> fired;
+
+static void RecordCallback(u64 userdata, s64 cycles_late) {
+    REQUIRE(0 == cycles_late);
+    fired.push_back(Fired{static_cast<s64>(CoreTiming::GetTicks()), userdata});
+}
+} // namespace StressTest
+
+TEST_CASE("CoreTiming[Stress]", "[core]") {
+    using namespace StressTest;
+
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", RecordCallback);
+    CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", RecordCallback);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    // Schedule thousands of events, many of them at the same time so that the FIFO order matters
+    constexpr u64 NUM_EVENTS = 8192;
+    std::vector<s64> times(NUM_EVENTS);
+    u32 seed = 12345;
+    for (u64 i = 0; i < NUM_EVENTS; ++i) {
+        seed = seed * 1103515245 + 12345;
+        times[i] = 1 + (seed >> 16) % 50000;
+        CoreTiming::ScheduleEvent(times[i], i % 2 ? cb_b : cb_a, i);
+    }
+
+    // Unschedule every third event and reschedule every fifth one at a new time, as services do.
+    std::vector<u64> expected_order;
+    std::vector<u64> rescheduled;
+    for (u64 i = 0; i < NUM_EVENTS; ++i) {
+        if (i % 3 == 0) {
+            CoreTiming::UnscheduleEvent(i % 2 ? cb_b : cb_a, i);
+        } else if (i % 5 == 0) {
+            CoreTiming::UnscheduleEvent(i % 2 ? cb_b : cb_a, i);
+            times[i] = 1 + (times[i] * 7) % 50000;
+            CoreTiming::ScheduleEvent(times[i], i % 2 ? cb_b : cb_a, i);
+            rescheduled.push_back(i);
+        } else {
+            expected_order.push_back(i);
+        }
+    }
+    // Rescheduled events come after the others scheduled for the same time
+    expected_order.insert(expected_order.end(), rescheduled.begin(), rescheduled.end());
+    std::stable_sort(expected_order.begin(), expected_order.end(),
+                     [&](u64 a, u64 b) { return times[a] < times[b]; });
+
+    fired.clear();
+    while (fired.size() < expected_order.size()) {
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+        REQUIRE(CoreTiming::GetTicks() <= 50000);
+    }
+
+    REQUIRE(fired.size() == expected_order.size());
+    for (size_t i = 0; i < fired.size(); ++i) {
+        REQUIRE(fired[i].userdata == expected_order[i]);
+        REQUIRE(fired[i].time == times[expected_order[i]]);
+    }
+
+    // RemoveEvent drops all events of a type and nothing else
+    for (u64 i = 0; i < 100; ++i) {
+        CoreTiming::ScheduleEvent(100 + i, i % 2 ? cb_b : cb_a, i);
+    }
+    CoreTiming::RemoveEvent(cb_a);
+    fired.clear();
+    CoreTiming::AddTicks(CoreTiming::GetDowncount());
+    CoreTiming::Advance();
+    while (CoreTiming::GetDowncount() != MAX_SLICE_LENGTH) {
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+    }
+    REQUIRE(fired.size() == 50);
+    for (const Fired& f : fired) {
+        REQUIRE(f.userdata % 2 == 1);
+    }
+}
+
+TEST_CASE("CoreTiming[EventStats]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+    CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", CallbackTemplate<1>);
+    CoreTiming::ResetEventStats();
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    CoreTiming::ScheduleEvent(100, cb_a, CB_IDS[0]);
+    CoreTiming::ScheduleEvent(200, cb_b, CB_IDS[1]);
+    CoreTiming::ScheduleEvent(300, cb_a, CB_IDS[0]);
+
+    AdvanceAndCheck(0, 100);
+    AdvanceAndCheck(1, 50, 50, -50); // (300 - 200 - 50)
+    AdvanceAndCheck(0, MAX_SLICE_LENGTH, 2, -2);
+
+    std::vector<CoreTiming::EventStats> stats = CoreTiming::GetEventStats();
+    auto find_stats = [&stats](const std::string& name) {
+        return *std::find_if(stats.begin(), stats.end(),
+                             [&name](const CoreTiming::EventStats& s) { return s.name == name; });
+    };
+
+    const CoreTiming::EventStats stats_a = find_stats("callbackA");
+    REQUIRE(2 == stats_a.fire_count);
+    REQUIRE(1 == stats_a.lateness_histogram[0]); // On time
+    REQUIRE(1 == stats_a.lateness_histogram[2]); // 2 cycles late
+
+    const CoreTiming::EventStats stats_b = find_stats("callbackB");
+    REQUIRE(1 == stats_b.fire_count);
+    REQUIRE(1 == stats_b.lateness_histogram[6]); // 50 cycles late
+
+    CoreTiming::ResetEventStats();
+    stats = CoreTiming::GetEventStats();
+    REQUIRE(0 == find_stats("callbackA").fire_count);
+    REQUIRE(0 == find_stats("callbackB").lateness_histogram[6]);
+}
+
+namespace ThreadsafeOrderTest {
+static std::vector<u64> fired;
+
+static void RecordCallback(u64 userdata, s64 cycles_late) {
+    fired.push_back(userdata);
+}
+} // namespace ThreadsafeOrderTest
+
+TEST_CASE("CoreTiming[ThreadsafeOrder]", "[core]") {
+    using namespace ThreadsafeOrderTest;
+
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb = CoreTiming::RegisterEvent("callback", RecordCallback);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    // Push far more events than fit into the lock-free queue, all for the same time, while the
+    // emu thread moves them over. Each producer's events must fire in the order it pushed them,
+    // also when some of them had to go through the overflow path.
+    constexpr u32 NUM_PRODUCERS = 2;
+    constexpr u32 NUM_EVENTS = 20000;
+    std::atomic<u32> producers_done{0};
+    std::vector<std::thread> producers;
+    for (u32 producer = 0; producer < NUM_PRODUCERS; ++producer) {
+        producers.emplace_back([cb, producer, &producers_done] {
+            for (u32 i = 0; i < NUM_EVENTS; ++i) {
+                CoreTiming::ScheduleEventThreadsafe(1000, cb,
+                                                    (static_cast<u64>(producer) << 32) | i);
+                if (i % 1024 == 0)
+                    std::this_thread::yield();
+            }
+            producers_done++;
+        });
+    }
+    while (producers_done < NUM_PRODUCERS) {
+        CoreTiming::MoveEvents();
+        std::this_thread::yield();
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    fired.clear();
+    CoreTiming::AddTicks(CoreTiming::GetDowncount());
+    CoreTiming::Advance();
+
+    REQUIRE(fired.size() == NUM_PRODUCERS * NUM_EVENTS);
+    std::array<u32, NUM_PRODUCERS> next{};
+    bool in_order = true;
+    for (u64 userdata : fired) {
+        const u32 producer = static_cast<u32>(userdata >> 32);
+        in_order &= static_cast<u32>(userdata) == next[producer]++;
+    }
+    REQUIRE(in_order);
+}
+
+TEST_CASE("CoreTiming[Benchmark]", "[.][benchmark]") {
+    for (u64 num_pending : {1000, 4000, 16000}) {
+        ScopeInit guard;
+
+        CoreTiming::EventType* cb = CoreTiming::RegisterEvent("callback", [](u64, s64) {});
+
+        // Enter slice 0
+        CoreTiming::Advance();
+
+        u32 seed = 12345;
+        auto next_time = [&seed] {
+            seed = seed * 1103515245 + 12345;
+            return static_cast<s64>(1000 + (seed >> 8) % 1000000);
+        };
+        for (u64 i = 0; i < num_pending; ++i) {
+            CoreTiming::ScheduleEvent(next_time(), cb, i);
+        }
+
+        // Reschedule events in a different order than they were scheduled, like services
+        // cancelling and restarting timeouts
+        constexpr u64 num_reschedules = 100000;
+        const auto start = std::chrono::steady_clock::now();
+        for (u64 i = 0; i < num_reschedules; ++i) {
+            const u64 userdata = (i * 7919) % num_pending;
+            CoreTiming::UnscheduleEvent(cb, userdata);
+            CoreTiming::ScheduleEvent(next_time(), cb, userdata);
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        std::printf("%llu pending events: %.0f ns per unschedule and schedule\n",
+                    static_cast<unsigned long long>(num_pending),
+                    elapsed.count() / num_reschedules);
+    }
+}
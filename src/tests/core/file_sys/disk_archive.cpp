@@ -0,0 +1,231 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/core_timing.h"
+#include "core/file_sys/disk_archive.h"
+#include "core/settings.h"
+
+namespace FileSys {
+
+static std::unique_ptr<DiskFile> OpenDiskFile(const std::string& path,
+                                              const char* host_mode = "r+b") {
+    Mode mode;
+    mode.hex = 0;
+    mode.read_flag.Assign(1);
+    mode.write_flag.Assign(1);
+    return std::make_unique<DiskFile>(FileUtil::IOFile(path, host_mode), mode, path);
+}
+
+static std::vector<u8> ReadHostFile(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    std::vector<u8> data(static_cast<size_t>(file.GetSize()));
+    file.ReadBytes(data.data(), data.size());
+    return data;
+}
+
+static std::vector<u8> ReadDiskFile(const DiskFile& file, u64 offset, size_t length) {
+    std::vector<u8> data(length);
+    const ResultVal<size_t> read = file.Read(offset, length, data.data());
+    REQUIRE(read.Succeeded());
+    data.resize(*read);
+    return data;
+}
+
+TEST_CASE("DiskFile write back", "[core][file_sys]") {
+    const std::string path = "disk_archive_test_file.bin";
+    {
+        FileUtil::IOFile file(path, "wb");
+        const std::vector<u8> initial(0x100, 0xAA);
+        REQUIRE(file.WriteBytes(initial.data(), initial.size()) == initial.size());
+    }
+    const bool cache_file_writes = Settings::values.cache_file_writes;
+    Settings::values.cache_file_writes = true;
+
+    auto file = OpenDiskFile(path);
+
+    SECTION("reads see the cached writes before they reach the host file") {
+        const std::vector<u8> first(0x10, 0x11);
+        const std::vector<u8> second(0x10, 0x22);
+        REQUIRE(*file->Write(0x10, first.size(), true, first.data()) == first.size());
+        REQUIRE(*file->Write(0x18, second.size(), true, second.data()) == second.size());
+
+        std::vector<u8> expected(0x30, 0xAA);
+        std::memset(expected.data() + 0x10, 0x11, 0x8);
+        std::memset(expected.data() + 0x18, 0x22, 0x10);
+        CHECK(ReadDiskFile(*file, 0, 0x30) == expected);
+        CHECK(ReadHostFile(path) == std::vector<u8>(0x100, 0xAA));
+
+        file->Flush();
+        expected.resize(0x100, 0xAA);
+        CHECK(ReadHostFile(path) == expected);
+    }
+
+    SECTION("writes past the end grow the file") {
+        const std::vector<u8> data(0x10, 0x33);
+        REQUIRE(*file->Write(0x200, data.size(), false, data.data()) == data.size());
+        CHECK(file->GetSize() == 0x210);
+
+        std::vector<u8> expected(0x120, 0);
+        std::memset(expected.data(), 0xAA, 0x10);
+        std::memset(expected.data() + 0x110, 0x33, 0x10);
+        CHECK(ReadDiskFile(*file, 0xF0, 0x200) == expected);
+
+        file->Close();
+        file.reset();
+        const std::vector<u8> host_data = ReadHostFile(path);
+        REQUIRE(host_data.size() == 0x210);
+        CHECK(std::vector<u8>(host_data.begin() + 0xF0, host_data.end()) == expected);
+    }
+
+    SECTION("overlapping writes are merged in order") {
+        std::vector<u8> expected(0x100, 0xAA);
+        std::mt19937 random(0);
+        for (int i = 0; i < 1000; ++i) {
+            const size_t offset = random() % 0x400;
+            std::vector<u8> data(random() % 0x40 + 1, static_cast<u8>(i));
+            REQUIRE(*file->Write(offset, data.size(), false, data.data()) == data.size());
+            expected.resize(std::max(expected.size(), offset + data.size()), 0);
+            std::copy(data.begin(), data.end(), expected.begin() + offset);
+        }
+
+        CHECK(file->GetSize() == expected.size());
+        CHECK(ReadDiskFile(*file, 0, 0x1000) == expected);
+        file->Flush();
+        CHECK(ReadHostFile(path) == expected);
+    }
+
+    SECTION("writes are cached only while the file is open once") {
+        const std::vector<u8> data(0x10, 0x44);
+        REQUIRE(*file->Write(0, data.size(), false, data.data()) == data.size());
+
+        // Opening the file again writes the cached data back
+        auto other_file = OpenDiskFile(path);
+        CHECK(ReadDiskFile(*other_file, 0, 0x10) == data);
+
+        const std::vector<u8> other_data(0x10, 0x55);
+        REQUIRE(*other_file->Write(0x20, other_data.size(), true, other_data.data()) ==
+                other_data.size());
+        CHECK(ReadDiskFile(*file, 0x20, 0x10) == other_data);
+    }
+
+    SECTION("data that could not be written back stays cached and journaled") {
+        // Writes to a host file opened read-only fail
+        file.reset();
+        file = OpenDiskFile(path, "rb");
+        const std::vector<u8> data(0x10, 0x66);
+        REQUIRE(*file->Write(0x40, data.size(), false, data.data()) == data.size());
+        CHECK(!file->Flush());
+        CHECK(!file->SetSize(0x80));
+        CHECK(!file->Close());
+        CHECK(ReadDiskFile(*file, 0x40, 0x10) == data);
+        CHECK(ReadHostFile(path) == std::vector<u8>(0x100, 0xAA));
+
+        // The journal is replayed once the file can be written again
+        file.reset();
+        file = OpenDiskFile(path);
+        std::vector<u8> expected(0x100, 0xAA);
+        std::memset(expected.data() + 0x40, 0x66, 0x10);
+        CHECK(ReadHostFile(path) == expected);
+    }
+
+    file.reset();
+    Settings::values.cache_file_writes = cache_file_writes;
+    FileUtil::Delete(path);
+}
+
+/// Runs the emulated CPU until the given number of cycles have passed since start
+static void RunCycles(u64 start, s64 cycles) {
+    while (CoreTiming::GetTicks() - start < static_cast<u64>(cycles)) {
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+    }
+}
+
+TEST_CASE("DiskFile timed write back", "[core][file_sys]") {
+    const std::string path = "disk_archive_timed_test_file.bin";
+    const std::vector<u8> initial(0x100, 0xAA);
+    {
+        FileUtil::IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes(initial.data(), initial.size()) == initial.size());
+    }
+    const bool cache_file_writes = Settings::values.cache_file_writes;
+    Settings::values.cache_file_writes = true;
+    CoreTiming::Init();
+    DiskArchiveInit();
+    CoreTiming::Advance();
+
+    auto file = OpenDiskFile(path);
+    const u64 start = CoreTiming::GetTicks();
+    const std::vector<u8> data(0x10, 0x77);
+    REQUIRE(*file->Write(0, data.size(), false, data.data()) == data.size());
+
+    // Nothing is written back until the cached data is a few seconds old
+    RunCycles(start, msToCycles(4900));
+    CHECK(ReadHostFile(path) == initial);
+    RunCycles(start, msToCycles(5100));
+    std::vector<u8> expected = initial;
+    std::copy(data.begin(), data.end(), expected.begin());
+    CHECK(ReadHostFile(path) == expected);
+
+    file.reset();
+    DiskArchiveShutdown();
+    CoreTiming::Shutdown();
+    Settings::values.cache_file_writes = cache_file_writes;
+    FileUtil::Delete(path);
+}
+
+/// Gets the number of write system calls made by this process so far, or 0 if not available
+static u64 GetWriteSyscallCount() {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    u64 value;
+    while (io >> key >> value) {
+        if (key == "syscw:")
+            return value;
+    }
+    return 0;
+}
+
+TEST_CASE("DiskFile write back benchmark", "[.][benchmark]") {
+    const std::string path = "disk_archive_benchmark_file.bin";
+    const bool cache_file_writes = Settings::values.cache_file_writes;
+    const std::vector<u8> data(0x40, 0x66);
+
+    for (bool write_back : {false, true}) {
+        FileUtil::IOFile(path, "wb");
+        Settings::values.cache_file_writes = write_back;
+
+        const u64 syscalls_before = GetWriteSyscallCount();
+        const auto start = std::chrono::steady_clock::now();
+        {
+            auto file = OpenDiskFile(path);
+            for (u64 i = 0; i < 1000; ++i) {
+                file->Write(i * data.size(), data.size(), true, data.data());
+            }
+            file->Close();
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        std::printf("write back %s: %.0f us, %llu write syscalls\n", write_back ? "on" : "off",
+                    elapsed.count(),
+                    static_cast<unsigned long long>(GetWriteSyscallCount() - syscalls_before));
+    }
+
+    Settings::values.cache_file_writes = cache_file_writes;
+    FileUtil::Delete(path);
+}
+
+} // namespace FileSys
@@ -0,0 +1,115 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/ivfc_archive.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+
+namespace FileSys {
+
+static std::shared_ptr<FileUtil::IOFile> CreateRomFS(const std::string& path, u64 size) {
+    {
+        FileUtil::IOFile file(path, "wb");
+        std::vector<u8> chunk(0x10000);
+        for (u64 offset = 0; offset < size; offset += chunk.size()) {
+            for (size_t i = 0; i < chunk.size(); ++i) {
+                chunk[i] = static_cast<u8>((offset + i) * 7 + (offset >> 16));
+            }
+            file.WriteBytes(chunk.data(), chunk.size());
+        }
+    }
+    return std::make_shared<FileUtil::IOFile>(path, "rb");
+}
+
+TEST_CASE("IVFCFile::ReadScattered", "[core][file_sys]") {
+    const std::string romfs_path = "ivfc_archive_test_romfs.bin";
+    const u64 romfs_size = 0x40000;
+    auto romfs_file = CreateRomFS(romfs_path, romfs_size);
+    {
+        // The file starts past the RomFS header, like the files of a real RomFS
+        IVFCFile file(romfs_file, 0x1000, romfs_size - 0x1000);
+
+        std::vector<u8> expected(0x3000);
+        REQUIRE(*file.Read(0x2010, expected.size(), expected.data()) == expected.size());
+
+        std::vector<u8> first(0x1234), second(expected.size() - first.size());
+        const std::vector<Memory::HostRegion> regions = {{first.data(), first.size()},
+                                                         {second.data(), second.size()}};
+        REQUIRE(*file.ReadScattered(0x2010, regions) == expected.size());
+        CHECK(std::equal(first.begin(), first.end(), expected.begin()));
+        CHECK(std::equal(second.begin(), second.end(), expected.begin() + first.size()));
+
+        // Reads are cut short at the end of the file
+        std::vector<u8> tail(0x1000);
+        REQUIRE(*file.Read(file.GetSize() - tail.size(), tail.size(), tail.data()) == tail.size());
+        REQUIRE(*file.ReadScattered(file.GetSize() - tail.size(), regions) == tail.size());
+        CHECK(std::equal(tail.begin(), tail.end(), first.begin()));
+    }
+    romfs_file->Close();
+    FileUtil::Delete(romfs_path);
+}
+
+TEST_CASE("IVFCFile streaming benchmark", "[.][benchmark]") {
+    // Streams a RomFS file sequentially into guest memory, the way games load their assets, once
+    // the way FS:File::Read used to do it and once the way it does it now
+    const std::string romfs_path = "ivfc_archive_benchmark_romfs.bin";
+    const u64 romfs_size = 64 * 1024 * 1024;
+    auto romfs_file = CreateRomFS(romfs_path, romfs_size);
+    IVFCFile file(romfs_file, 0, romfs_size);
+
+    auto process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+    constexpr u32 block_size = 4 * 1024 * 1024;
+    auto block = std::make_shared<std::vector<u8>>(block_size);
+    process->vm_manager.MapMemoryBlock(Memory::HEAP_VADDR, block, 0, block_size,
+                                       Kernel::MemoryState::Private);
+
+    for (u32 chunk_size : {0x1000u, 0x10000u, 0x100000u, block_size}) {
+        auto time = [&](const char* name, auto&& read_chunk) {
+            // One pass to fault the mapping in, so both paths read from the page cache
+            for (u64 offset = 0; offset < romfs_size; offset += chunk_size) {
+                read_chunk(offset);
+            }
+
+            constexpr int passes = 4;
+            const auto start = std::chrono::steady_clock::now();
+            for (int pass = 0; pass < passes; ++pass) {
+                for (u64 offset = 0; offset < romfs_size; offset += chunk_size) {
+                    read_chunk(offset);
+                }
+            }
+            const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            std::printf("%s in chunks of 0x%x bytes: %.0f MB/s\n", name, chunk_size,
+                        static_cast<double>(romfs_size) * passes / elapsed.count() / 1e6);
+        };
+
+        time("Read + WriteBlock", [&](u64 offset) {
+            std::vector<u8> data(chunk_size);
+            const size_t read = *file.Read(offset, data.size(), data.data());
+            Memory::WriteBlock(*process, Memory::HEAP_VADDR, data.data(), read);
+        });
+
+        std::vector<Memory::HostRegion> regions;
+        time("ReadScattered", [&](u64 offset) {
+            if (Memory::GetHostRegions(*process, Memory::HEAP_VADDR, chunk_size,
+                                       Memory::FlushMode::FlushAndInvalidate, regions)) {
+                file.ReadScattered(offset, regions);
+            }
+        });
+    }
+
+    romfs_file->Close();
+    FileUtil::Delete(romfs_path);
+}
+
+} // namespace FileSys
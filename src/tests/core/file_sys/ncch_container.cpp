@@ -0,0 +1,196 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_types.h"
+#include "core/file_sys/ncch_container.h"
+
+namespace FileSys {
+
+// The straightforward byte at a time implementation, which the optimized one is checked and
+// benchmarked against
+static bool LZSS_DecompressReference(const u8* compressed, u32 compressed_size, u8* decompressed,
+                                     u32 decompressed_size) {
+    const u8* footer = compressed + compressed_size - 8;
+    u32 buffer_top_and_bottom = *reinterpret_cast<const u32*>(footer);
+    u32 out = decompressed_size;
+    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
+    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
+
+    std::memset(decompressed, 0, decompressed_size);
+    std::memcpy(decompressed, compressed, compressed_size);
+
+    while (index > stop_index) {
+        u8 control = compressed[--index];
+
+        for (unsigned i = 0; i < 8; i++) {
+            if (index <= stop_index || out <= 0)
+                break;
+
+            if (control & 0x80) {
+                if (index < 2)
+                    return false;
+                index -= 2;
+
+                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
+                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
+                segment_offset &= 0x0FFF;
+                segment_offset += 2;
+
+                if (out < segment_size)
+                    return false;
+
+                for (unsigned j = 0; j < segment_size; j++) {
+                    if (out + segment_offset >= decompressed_size)
+                        return false;
+
+                    u8 data = decompressed[out + segment_offset];
+                    decompressed[--out] = data;
+                }
+            } else {
+                if (out < 1)
+                    return false;
+                decompressed[--out] = compressed[--index];
+            }
+            control <<= 1;
+        }
+    }
+    return true;
+}
+
+struct CompressedData {
+    std::vector<u8> compressed;
+    std::vector<u8> decompressed;
+};
+
+/**
+ * Generates LZSS compressed data out of random literals and back-references, along with the data
+ * it decompresses to. The data is decompressed from the end, and back-references copy data that
+ * was already decompressed, from higher addresses.
+ */
+static CompressedData GenerateCompressedData(size_t num_control_bytes, size_t prefix_size,
+                                             std::mt19937& rng) {
+    // The compressed stream in the order it is read, which is from the end of the buffer, and the
+    // decompressed data in the order it is written, which is also from the end of the buffer
+    std::vector<u8> stream;
+    std::vector<u8> output;
+
+    for (size_t i = 0; i < num_control_bytes; ++i) {
+        const size_t control_position = stream.size();
+        stream.push_back(0);
+
+        u8 control = 0;
+        for (unsigned bit = 0; bit < 8; ++bit) {
+            control <<= 1;
+            // Back-references need at least 3 bytes of data to copy from
+            if (output.size() < 3 || rng() % 4 == 0) {
+                const u8 literal = static_cast<u8>(rng());
+                stream.push_back(literal);
+                output.push_back(literal);
+                continue;
+            }
+
+            // Mix up short distances, where the copy overlaps itself, with long ones
+            const size_t max_distance = std::min<size_t>(output.size() - 2, 0x1000);
+            const u32 distance = static_cast<u32>(rng() % (rng() % 2 ? 16 : max_distance)) %
+                                 static_cast<u32>(max_distance);
+            const u32 size_field = rng() % 16;
+            const u16 segment = static_cast<u16>(size_field << 12 | distance);
+            stream.push_back(static_cast<u8>(segment >> 8));
+            stream.push_back(static_cast<u8>(segment & 0xFF));
+            control |= 1;
+
+            for (u32 j = 0; j < size_field + 3; ++j) {
+                output.push_back(output[output.size() - 3 - distance]);
+            }
+        }
+        stream[control_position] = control;
+    }
+
+    CompressedData data;
+    data.compressed.resize(prefix_size);
+    for (u8& byte : data.compressed) {
+        byte = static_cast<u8>(rng());
+    }
+    data.decompressed = data.compressed;
+    data.compressed.insert(data.compressed.end(), stream.rbegin(), stream.rend());
+    data.decompressed.insert(data.decompressed.end(), output.rbegin(), output.rend());
+
+    // The footer holds the size of the footer and of the compressed stream, and the difference
+    // between the compressed and the decompressed size
+    const u32 footer_size = 8;
+    const u32 top_and_bottom = footer_size << 24 | static_cast<u32>(stream.size() + footer_size);
+    const u32 size_difference =
+        static_cast<u32>(data.decompressed.size() - data.compressed.size() - footer_size);
+    REQUIRE(data.decompressed.size() >= data.compressed.size() + footer_size);
+    data.compressed.resize(data.compressed.size() + footer_size);
+    std::memcpy(&data.compressed[data.compressed.size() - 8], &top_and_bottom, sizeof(u32));
+    std::memcpy(&data.compressed[data.compressed.size() - 4], &size_difference, sizeof(u32));
+    return data;
+}
+
+TEST_CASE("LZSS_Decompress", "[core][file_sys]") {
+    std::mt19937 rng(1234);
+
+    SECTION("random data decompresses like the reference implementation") {
+        for (size_t control_bytes : {1, 7, 100, 5000}) {
+            const CompressedData data = GenerateCompressedData(control_bytes, 0x40, rng);
+            const u32 compressed_size = static_cast<u32>(data.compressed.size());
+            const u32 decompressed_size =
+                LZSS_GetDecompressedSize(data.compressed.data(), compressed_size);
+            REQUIRE(decompressed_size == data.decompressed.size());
+
+            std::vector<u8> decompressed(decompressed_size, 0xCC);
+            REQUIRE(LZSS_Decompress(data.compressed.data(), compressed_size, decompressed.data(),
+                                    decompressed_size));
+            CHECK(decompressed == data.decompressed);
+
+            std::vector<u8> reference(decompressed_size, 0xCC);
+            REQUIRE(LZSS_DecompressReference(data.compressed.data(), compressed_size,
+                                             reference.data(), decompressed_size));
+            CHECK(reference == decompressed);
+        }
+    }
+
+    SECTION("back-references past the end of the data are rejected") {
+        // A single back-reference as the first token, with nothing to copy from yet
+        const std::vector<u8> compressed{0x00, 0x00, 0x80, 0x0B, 0x00, 0x00, 0x08,
+                                         0x10, 0x00, 0x00, 0x00};
+        const u32 decompressed_size =
+            LZSS_GetDecompressedSize(compressed.data(), static_cast<u32>(compressed.size()));
+        std::vector<u8> decompressed(decompressed_size);
+        CHECK_FALSE(LZSS_Decompress(compressed.data(), static_cast<u32>(compressed.size()),
+                                    decompressed.data(), decompressed_size));
+    }
+}
+
+TEST_CASE("LZSS_Decompress benchmark", "[.][benchmark]") {
+    std::mt19937 rng(1234);
+    const CompressedData data = GenerateCompressedData(1 << 16, 0x1000, rng);
+    const u32 compressed_size = static_cast<u32>(data.compressed.size());
+    const u32 decompressed_size = static_cast<u32>(data.decompressed.size());
+    std::vector<u8> decompressed(decompressed_size);
+
+    constexpr int iterations = 20;
+    const auto measure = [&](auto decompress) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            REQUIRE(decompress(data.compressed.data(), compressed_size, decompressed.data(),
+                               decompressed_size));
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return decompressed_size * iterations / elapsed.count() / (1024 * 1024);
+    };
+
+    const double reference_speed = measure(LZSS_DecompressReference);
+    const double speed = measure(LZSS_Decompress);
+    WARN("Reference: " << reference_speed << " MiB/s, optimized: " << speed << " MiB/s");
+}
+
+} // namespace FileSys
@@ -0,0 +1,71 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/romfs_prefetcher.h"
+
+namespace FileSys {
+
+TEST_CASE("RomFSPrefetcher", "[core][file_sys]") {
+    const std::string romfs_path = "romfs_prefetcher_test_romfs.bin";
+    const std::string trace_path = "romfs_prefetcher_test_trace.bin";
+    const u64 romfs_size = 4 * 1024 * 1024;
+    {
+        FileUtil::IOFile file(romfs_path, "wb");
+        REQUIRE(file.Resize(romfs_size));
+    }
+    FileUtil::Delete(trace_path);
+
+    FileUtil::IOFile romfs_file(romfs_path, "rb");
+    auto mapping = std::make_shared<const FileUtil::MappedFile>(romfs_file, 0, romfs_size);
+    REQUIRE(mapping->IsOpen());
+
+    // Without a trace nothing is prefetched, and the reads are recorded
+    {
+        RomFSPrefetcher prefetcher(trace_path, romfs_size, mapping);
+        prefetcher.RecordRead(0, 0x1000);
+        prefetcher.RecordRead(0x1000, 0x1000);
+        prefetcher.RecordRead(0x200000, 0x10000);
+        const RomFSPrefetcher::Stats stats = prefetcher.GetStats();
+        CHECK(stats.hits == 0);
+        CHECK(stats.misses == 3);
+        CHECK(stats.prefetched_bytes == 0);
+    }
+
+    SECTION("the recorded reads are prefetched in the next session") {
+        RomFSPrefetcher prefetcher(trace_path, romfs_size, mapping);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (prefetcher.GetStats().prefetched_bytes < 0x12000 &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(prefetcher.GetStats().prefetched_bytes == 0x12000);
+
+        prefetcher.RecordRead(0x800, 0x1000);
+        prefetcher.RecordRead(0x200000, 0x10000);
+        prefetcher.RecordRead(0x1800, 0x1000);
+        prefetcher.RecordRead(0x300000, 0x10);
+        const RomFSPrefetcher::Stats stats = prefetcher.GetStats();
+        CHECK(stats.hits == 2);
+        CHECK(stats.misses == 2);
+    }
+
+    SECTION("traces of a RomFS of another size are ignored") {
+        RomFSPrefetcher prefetcher(trace_path, romfs_size / 2, mapping);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        CHECK(prefetcher.GetStats().prefetched_bytes == 0);
+    }
+
+    romfs_file.Close();
+    FileUtil::Delete(romfs_path);
+    FileUtil::Delete(trace_path);
+}
+
+} // namespace FileSys
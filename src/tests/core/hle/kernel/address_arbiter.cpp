@@ -0,0 +1,112 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <catch.hpp>
+#include "core/hle/kernel/address_arbiter.h"
+
+using WaitList = Kernel::ArbitrationWaitList<int>;
+
+TEST_CASE("ArbitrationWaitList: Signal", "[kernel]") {
+    // Waiters are thread ids, indexing their priority
+    std::vector<u32> priorities = {0, 0x30, 0x20, 0x30, 0x20, 0x18};
+    auto get_priority = [&priorities](int thread) { return priorities[thread]; };
+
+    WaitList waiters;
+    for (int thread = 1; thread <= 4; ++thread) {
+        waiters.Add(0x1000, thread);
+    }
+    waiters.Add(0x2000, 5);
+    REQUIRE(waiters.Count(0x1000) == 4);
+    REQUIRE(waiters.NumAddresses() == 2);
+
+    SECTION("highest priority first, first waiter on ties") {
+        REQUIRE(waiters.TakeHighestPriority(0x1000, 1, get_priority) == std::vector<int>{2});
+        REQUIRE(waiters.TakeHighestPriority(0x1000, 2, get_priority) == std::vector<int>{4, 1});
+        REQUIRE(waiters.Count(0x1000) == 1);
+    }
+
+    SECTION("priorities are compared when signaled") {
+        priorities[3] = 0x10;
+        REQUIRE(waiters.TakeHighestPriority(0x1000, 1, get_priority) == std::vector<int>{3});
+    }
+
+    SECTION("signal N stops once the address has no waiters left") {
+        REQUIRE(waiters.TakeHighestPriority(0x1000, 0x7FFFFFFF, get_priority) ==
+                std::vector<int>{2, 4, 1, 3});
+        REQUIRE(waiters.Count(0x1000) == 0);
+        REQUIRE(waiters.NumAddresses() == 1);
+        REQUIRE(waiters.TakeHighestPriority(0x1000, 5, get_priority).empty());
+        REQUIRE(waiters.TakeHighestPriority(0x3000, 5, get_priority).empty());
+    }
+
+    SECTION("signal 0 resumes nothing") {
+        REQUIRE(waiters.TakeHighestPriority(0x1000, 0, get_priority).empty());
+        REQUIRE(waiters.Count(0x1000) == 4);
+    }
+
+    SECTION("signal all keeps the wait order") {
+        REQUIRE(waiters.TakeAll(0x1000) == std::vector<int>{1, 2, 3, 4});
+        REQUIRE(waiters.NumAddresses() == 1);
+        REQUIRE(waiters.TakeAll(0x1000).empty());
+    }
+
+    // Other addresses are left alone
+    REQUIRE(waiters.Count(0x2000) == 1);
+}
+
+TEST_CASE("ArbitrationWaitList: Timeout removal", "[kernel]") {
+    WaitList waiters;
+    waiters.Add(0x1000, 1);
+    waiters.Add(0x1000, 2);
+    waiters.Add(0x2000, 3);
+
+    // A thread is only removed from the address it waits on
+    REQUIRE(!waiters.Remove(0x2000, 1));
+    REQUIRE(waiters.Remove(0x1000, 1));
+    REQUIRE(!waiters.Remove(0x1000, 1));
+    REQUIRE(waiters.TakeAll(0x1000) == std::vector<int>{2});
+
+    // The address goes away with its last waiter
+    REQUIRE(waiters.Remove(0x2000, 3));
+    REQUIRE(waiters.NumAddresses() == 0);
+    REQUIRE(!waiters.Remove(0x2000, 3));
+}
+
+TEST_CASE("ArbitrationWaitList: Contention benchmark", "[.][benchmark]") {
+    // Every thread waits on one of a few addresses, like the barriers and semaphores games build
+    // on top of arbiters. Each iteration signals one waiter of an address, which waits again.
+    for (int num_addresses : {1, 8, 64}) {
+        for (int num_threads : {16, 128}) {
+            constexpr int NUM_ITERATIONS = 200000;
+            std::vector<u32> priorities(num_threads);
+            for (int thread = 0; thread < num_threads; ++thread) {
+                priorities[thread] = 0x18 + thread % 0x20;
+            }
+            auto get_priority = [&priorities](int thread) { return priorities[thread]; };
+
+            WaitList waiters;
+            for (int thread = 0; thread < num_threads; ++thread) {
+                waiters.Add(0x1000 + 4 * (thread % num_addresses), thread);
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            int checksum = 0;
+            for (int i = 0; i < NUM_ITERATIONS; ++i) {
+                const VAddr address = 0x1000 + 4 * (i % num_addresses);
+                for (int thread : waiters.TakeHighestPriority(address, 1, get_priority)) {
+                    checksum += thread;
+                    waiters.Add(address, thread);
+                }
+            }
+            const std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            std::printf("%d addresses, %d threads: %.1f ns per signal (checksum %d)\n",
+                        num_addresses, num_threads, elapsed.count() / NUM_ITERATIONS, checksum);
+        }
+    }
+}
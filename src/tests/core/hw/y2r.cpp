@@ -0,0 +1,330 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "common/color.h"
+#include "common/vector_math.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+
+namespace HW {
+namespace Y2R {
+
+using namespace Service::Y2R;
+
+static constexpr VAddr SRC_Y_ADDRESS = Memory::HEAP_VADDR;
+static constexpr VAddr SRC_U_ADDRESS = Memory::HEAP_VADDR + 0x80000;
+static constexpr VAddr SRC_V_ADDRESS = Memory::HEAP_VADDR + 0xC0000;
+static constexpr VAddr DST_ADDRESS = Memory::HEAP_VADDR + 0x100000;
+static constexpr size_t MEMORY_SIZE = 0x180000;
+
+/// Maps memory for the conversions to use, and returns its host pointer
+static u8* MapConversionMemory(Kernel::SharedPtr<Kernel::Process>& process) {
+    process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+    auto block = std::make_shared<std::vector<u8>>(MEMORY_SIZE, 0);
+    process->vm_manager.MapMemoryBlock(Memory::HEAP_VADDR, block, 0, MEMORY_SIZE,
+                                       Kernel::MemoryState::Private);
+    Memory::SetCurrentPageTable(&process->vm_manager.page_table);
+    return block->data();
+}
+
+static bool IsInterleaved(InputFormat format) {
+    return format == InputFormat::YUYV422_Interleaved;
+}
+
+static bool Is420(InputFormat format) {
+    return format == InputFormat::YUV420_Indiv8 || format == InputFormat::YUV420_Indiv16;
+}
+
+static size_t BytesPerInputValue(InputFormat format) {
+    return format == InputFormat::YUV422_Indiv16 || format == InputFormat::YUV420_Indiv16 ? 2 : 1;
+}
+
+static size_t BytesPerPixel(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+static ConversionConfiguration MakeConfiguration(InputFormat input_format,
+                                                 OutputFormat output_format, u16 width,
+                                                 u16 height, const CoefficientSet& coefficients) {
+    ConversionConfiguration cvt{};
+    cvt.input_format = input_format;
+    cvt.output_format = output_format;
+    cvt.rotation = Rotation::None;
+    cvt.block_alignment = BlockAlignment::Linear;
+    cvt.input_line_width = width;
+    cvt.input_lines = height;
+    cvt.coefficients = coefficients;
+    cvt.alpha = 0x80;
+
+    const u16 n = static_cast<u16>(BytesPerInputValue(input_format));
+    const u32 uv_lines = Is420(input_format) ? height / 2 : height;
+    cvt.src_Y = {SRC_Y_ADDRESS, static_cast<u32>(width * height * n), static_cast<u16>(width * n),
+                 0};
+    cvt.src_U = {SRC_U_ADDRESS, width / 2 * uv_lines * n, static_cast<u16>(width / 2 * n), 0};
+    cvt.src_V = {SRC_V_ADDRESS, width / 2 * uv_lines * n, static_cast<u16>(width / 2 * n), 0};
+    cvt.src_YUYV = {SRC_Y_ADDRESS, static_cast<u32>(width * height * 2),
+                    static_cast<u16>(width * 2), 0};
+
+    const u16 bpp = static_cast<u16>(BytesPerPixel(output_format));
+    cvt.dst = {DST_ADDRESS, static_cast<u32>(width * height * bpp), static_cast<u16>(width * bpp),
+               0};
+    return cvt;
+}
+
+/// Straightforward per-pixel implementation of the conversion, as documented in CoefficientSet
+static Math::Vec4<u8> ReferenceConvert(s32 Y, s32 U, s32 V, const CoefficientSet& c, u8 alpha) {
+    s32 cY = c[0] * Y;
+    s32 r = ((cY + c[1] * V) >> 3) + c[5] + 0x18;
+    s32 g = ((cY - c[2] * V - c[3] * U) >> 3) + c[6] + 0x18;
+    s32 b = ((cY + c[4] * U) >> 3) + c[7] + 0x18;
+    const auto clamp = [](s32 value) { return static_cast<u8>(std::min(std::max(value, 0), 255)); };
+    return {clamp(r >> 5), clamp(g >> 5), clamp(b >> 5), alpha};
+}
+
+static std::vector<u8> ReferenceConversion(const ConversionConfiguration& cvt, const u8* memory) {
+    const u8* src_Y = memory + (SRC_Y_ADDRESS - Memory::HEAP_VADDR);
+    const u8* src_U = memory + (SRC_U_ADDRESS - Memory::HEAP_VADDR);
+    const u8* src_V = memory + (SRC_V_ADDRESS - Memory::HEAP_VADDR);
+    const size_t n = BytesPerInputValue(cvt.input_format);
+    const size_t bpp = BytesPerPixel(cvt.output_format);
+    const size_t width = cvt.input_line_width;
+
+    std::vector<u8> output(width * cvt.input_lines * bpp);
+    for (size_t y = 0; y < cvt.input_lines; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            s32 Y, U, V;
+            if (IsInterleaved(cvt.input_format)) {
+                Y = src_Y[(y * width + x) * 2];
+                U = src_Y[(y * width + x / 2 * 2) * 2 + 1];
+                V = src_Y[(y * width + x / 2 * 2) * 2 + 3];
+            } else {
+                const size_t uv_y = Is420(cvt.input_format) ? y / 2 : y;
+                Y = src_Y[(y * width + x) * n];
+                U = src_U[(uv_y * width / 2 + x / 2) * n];
+                V = src_V[(uv_y * width / 2 + x / 2) * n];
+            }
+
+            const Math::Vec4<u8> color =
+                ReferenceConvert(Y, U, V, cvt.coefficients, static_cast<u8>(cvt.alpha));
+            u8* out = &output[(y * width + x) * bpp];
+            switch (cvt.output_format) {
+            case OutputFormat::RGBA8:
+                Color::EncodeRGBA8(color, out);
+                break;
+            case OutputFormat::RGB8:
+                Color::EncodeRGB8(color, out);
+                break;
+            case OutputFormat::RGB5A1:
+                Color::EncodeRGB5A1(color, out);
+                break;
+            case OutputFormat::RGB565:
+                Color::EncodeRGB565(color, out);
+                break;
+            }
+        }
+    }
+    return output;
+}
+
+TEST_CASE("Y2R conversion matches the reference", "[core][hw]") {
+    Kernel::SharedPtr<Kernel::Process> process;
+    u8* memory = MapConversionMemory(process);
+
+    std::mt19937 random(0);
+    std::generate(memory, memory + DST_ADDRESS - Memory::HEAP_VADDR,
+                  [&] { return static_cast<u8>(random()); });
+
+    // Random coefficients, from the full range of their type, also cover clamping and overflows
+    CoefficientSet coefficients;
+    for (s16& coefficient : coefficients) {
+        coefficient = static_cast<s16>(random());
+    }
+    const CoefficientSet rec601 = {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}};
+
+    for (InputFormat input_format :
+         {InputFormat::YUV422_Indiv8, InputFormat::YUV420_Indiv8, InputFormat::YUV422_Indiv16,
+          InputFormat::YUV420_Indiv16, InputFormat::YUYV422_Interleaved}) {
+        for (OutputFormat output_format : {OutputFormat::RGBA8, OutputFormat::RGB8,
+                                           OutputFormat::RGB5A1, OutputFormat::RGB565}) {
+            for (const CoefficientSet& c : {rec601, coefficients}) {
+                INFO("input format " << static_cast<int>(input_format) << ", output format "
+                                     << static_cast<int>(output_format));
+                ConversionConfiguration cvt =
+                    MakeConfiguration(input_format, output_format, 72, 20, c);
+                const std::vector<u8> expected = ReferenceConversion(cvt, memory);
+                PerformConversion(cvt);
+
+                const u8* output = memory + (DST_ADDRESS - Memory::HEAP_VADDR);
+                REQUIRE(std::vector<u8>(output, output + expected.size()) == expected);
+            }
+        }
+    }
+}
+
+/// Index in the output strip of the pixel at (x, y) of an image strip, as PerformConversion lays
+/// out rotated strips
+static size_t RotatedIndex(const ConversionConfiguration& cvt, size_t x, size_t y, size_t height) {
+    static const u8 morton[64] = {
+        // clang-format off
+         0,  1,  4,  5, 16, 17, 20, 21,
+         2,  3,  6,  7, 18, 19, 22, 23,
+         8,  9, 12, 13, 24, 25, 28, 29,
+        10, 11, 14, 15, 26, 27, 30, 31,
+        32, 33, 36, 37, 48, 49, 52, 53,
+        34, 35, 38, 39, 50, 51, 54, 55,
+        40, 41, 44, 45, 56, 57, 60, 61,
+        42, 43, 46, 47, 58, 59, 62, 63,
+        // clang-format on
+    };
+    const size_t num_tiles = cvt.input_line_width / 8;
+    size_t tile = x / 8;
+    const size_t tile_x = x % 8;
+
+    // Index of the pixel within its rotated tile, and where the tile goes in the strip
+    size_t index = 0;
+    switch (cvt.rotation) {
+    case Rotation::None:
+        index = y * 8 + tile_x;
+        break;
+    case Rotation::Clockwise_90:
+        index = tile_x * height + (height - 1 - y);
+        break;
+    case Rotation::Clockwise_180:
+        tile = num_tiles - 1 - tile;
+        index = height * 8 - 1 - (y * 8 + tile_x);
+        break;
+    case Rotation::Clockwise_270:
+        tile = num_tiles - 1 - tile;
+        index = (7 - tile_x) * height + y;
+        break;
+    }
+
+    if (cvt.block_alignment == BlockAlignment::Block8x8)
+        return tile * 64 + morton[index];
+    if (cvt.rotation == Rotation::None || cvt.rotation == Rotation::Clockwise_180)
+        return index / 8 * cvt.input_line_width + tile * 8 + index % 8;
+    return tile * 8 * height + index;
+}
+
+TEST_CASE("Y2R rotation and block alignment", "[core][hw]") {
+    Kernel::SharedPtr<Kernel::Process> process;
+    u8* memory = MapConversionMemory(process);
+
+    std::mt19937 random(0);
+    std::generate(memory, memory + DST_ADDRESS - Memory::HEAP_VADDR,
+                  [&] { return static_cast<u8>(random()); });
+    const CoefficientSet rec601 = {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}};
+
+    // The last strip of the 20 lines high image is only 4 lines high
+    for (u16 height : {24, 20}) {
+        ConversionConfiguration cvt =
+            MakeConfiguration(InputFormat::YUV422_Indiv8, OutputFormat::RGBA8, 72, height, rec601);
+        const std::vector<u8> image = ReferenceConversion(cvt, memory);
+
+        for (BlockAlignment alignment : {BlockAlignment::Linear, BlockAlignment::Block8x8}) {
+            if (alignment == BlockAlignment::Block8x8 && height % 8 != 0)
+                continue;
+            for (Rotation rotation : {Rotation::None, Rotation::Clockwise_90,
+                                      Rotation::Clockwise_180, Rotation::Clockwise_270}) {
+                INFO("height " << height << ", alignment " << static_cast<int>(alignment)
+                               << ", rotation " << static_cast<int>(rotation));
+                cvt = MakeConfiguration(InputFormat::YUV422_Indiv8, OutputFormat::RGBA8, 72,
+                                        height, rec601);
+                cvt.rotation = rotation;
+                cvt.block_alignment = alignment;
+
+                // Rotations apply to each 8 lines high strip on its own
+                std::vector<u8> expected(image.size());
+                for (size_t strip = 0; strip < height; strip += 8) {
+                    const size_t strip_height = std::min<size_t>(height - strip, 8);
+                    const size_t strip_offset = strip * cvt.input_line_width * 4;
+                    for (size_t y = 0; y < strip_height; ++y) {
+                        for (size_t x = 0; x < cvt.input_line_width; ++x) {
+                            const size_t from = strip_offset + ((y * cvt.input_line_width) + x) * 4;
+                            const size_t to =
+                                strip_offset + RotatedIndex(cvt, x, y, strip_height) * 4;
+                            std::copy_n(&image[from], 4, &expected[to]);
+                        }
+                    }
+                }
+                PerformConversion(cvt);
+
+                const u8* output = memory + (DST_ADDRESS - Memory::HEAP_VADDR);
+                REQUIRE(std::vector<u8>(output, output + expected.size()) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Y2R conversion benchmark", "[.][benchmark]") {
+    Kernel::SharedPtr<Kernel::Process> process;
+    u8* memory = MapConversionMemory(process);
+    std::fill(memory, memory + DST_ADDRESS - Memory::HEAP_VADDR, 0x80);
+
+    const CoefficientSet rec601 = {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}};
+    for (InputFormat input_format :
+         {InputFormat::YUV420_Indiv8, InputFormat::YUYV422_Interleaved}) {
+        for (OutputFormat output_format : {OutputFormat::RGBA8, OutputFormat::RGB565}) {
+            constexpr int frames = 200;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i) {
+                ConversionConfiguration cvt =
+                    MakeConfiguration(input_format, output_format, 400, 240, rec601);
+                PerformConversion(cvt);
+            }
+            const std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+            std::printf("input format %d, output format %d: %.0f us per 400x240 frame\n",
+                        static_cast<int>(input_format), static_cast<int>(output_format),
+                        elapsed.count() / frames);
+        }
+    }
+}
+
+TEST_CASE("Y2R rotation benchmark", "[.][benchmark]") {
+    Kernel::SharedPtr<Kernel::Process> process;
+    u8* memory = MapConversionMemory(process);
+    std::fill(memory, memory + DST_ADDRESS - Memory::HEAP_VADDR, 0x80);
+
+    const CoefficientSet rec601 = {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}};
+    for (BlockAlignment alignment : {BlockAlignment::Linear, BlockAlignment::Block8x8}) {
+        for (Rotation rotation : {Rotation::None, Rotation::Clockwise_90, Rotation::Clockwise_180,
+                                  Rotation::Clockwise_270}) {
+            constexpr int frames = 200;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i) {
+                ConversionConfiguration cvt = MakeConfiguration(
+                    InputFormat::YUV420_Indiv8, OutputFormat::RGBA8, 400, 240, rec601);
+                cvt.rotation = rotation;
+                cvt.block_alignment = alignment;
+                PerformConversion(cvt);
+            }
+            const std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+            std::printf("alignment %d, rotation %d: %.0f us per 400x240 frame\n",
+                        static_cast<int>(alignment), static_cast<int>(rotation),
+                        elapsed.count() / frames);
+        }
+    }
+}
+
+} // namespace Y2R
+} // namespace HW
@@ -2,6 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
 #include <catch.hpp>
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
@@ -54,3 +59,134 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::ReadBlock/WriteBlock", "[core][memory]") {
+    auto process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+
+    // Two separately backed blocks right next to each other in the guest address space, followed
+    // by an unmapped page
+    auto block_a = std::make_shared<std::vector<u8>>(2 * Memory::PAGE_SIZE, 0);
+    auto block_b = std::make_shared<std::vector<u8>>(2 * Memory::PAGE_SIZE, 0);
+    const VAddr base = Memory::HEAP_VADDR;
+    process->vm_manager.MapMemoryBlock(base, block_a, 0, 2 * Memory::PAGE_SIZE,
+                                       Kernel::MemoryState::Private);
+    process->vm_manager.MapMemoryBlock(base + 2 * Memory::PAGE_SIZE, block_b, 0,
+                                       2 * Memory::PAGE_SIZE, Kernel::MemoryState::Private);
+
+    std::vector<u8> data(4 * Memory::PAGE_SIZE - 0x20);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 7);
+    }
+
+    SECTION("writes are split across backing blocks") {
+        Memory::WriteBlock(*process, base + 0x10, data.data(), data.size());
+        CHECK(std::equal(data.begin(), data.begin() + block_a->size() - 0x10,
+                         block_a->begin() + 0x10));
+        CHECK(std::equal(data.begin() + block_a->size() - 0x10, data.end(), block_b->begin()));
+
+        std::vector<u8> read_back(data.size());
+        Memory::ReadBlock(*process, base + 0x10, read_back.data(), read_back.size());
+        CHECK(read_back == data);
+    }
+
+    SECTION("unmapped pages read as zero") {
+        std::fill(block_b->begin(), block_b->end(), 0xFF);
+        std::vector<u8> read_back(2 * Memory::PAGE_SIZE, 0xAA);
+        Memory::ReadBlock(*process, base + 3 * Memory::PAGE_SIZE, read_back.data(),
+                          read_back.size());
+        CHECK(std::all_of(read_back.begin(), read_back.begin() + Memory::PAGE_SIZE,
+                          [](u8 value) { return value == 0xFF; }));
+        CHECK(std::all_of(read_back.begin() + Memory::PAGE_SIZE, read_back.end(),
+                          [](u8 value) { return value == 0; }));
+    }
+
+    SECTION("CopyBlock and ZeroBlock") {
+        Memory::WriteBlock(*process, base, data.data(), 2 * Memory::PAGE_SIZE);
+        Memory::CopyBlock(*process, base + 2 * Memory::PAGE_SIZE, base + 0x100,
+                          Memory::PAGE_SIZE + 0x200);
+        CHECK(std::equal(data.begin() + 0x100, data.begin() + Memory::PAGE_SIZE + 0x300,
+                         block_b->begin()));
+
+        Memory::ZeroBlock(*process, base + 0x80, 3 * Memory::PAGE_SIZE);
+        CHECK(std::all_of(block_a->begin() + 0x80, block_a->end(),
+                          [](u8 value) { return value == 0; }));
+        CHECK(std::all_of(block_b->begin(), block_b->begin() + Memory::PAGE_SIZE + 0x80,
+                          [](u8 value) { return value == 0; }));
+        CHECK((*block_a)[0x7F] == data[0x7F]);
+    }
+}
+
+TEST_CASE("Memory::GetHostRegions", "[core][memory]") {
+    auto process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+
+    auto block_a = std::make_shared<std::vector<u8>>(2 * Memory::PAGE_SIZE, 0);
+    auto block_b = std::make_shared<std::vector<u8>>(2 * Memory::PAGE_SIZE, 0);
+    const VAddr base = Memory::HEAP_VADDR;
+    process->vm_manager.MapMemoryBlock(base, block_a, 0, 2 * Memory::PAGE_SIZE,
+                                       Kernel::MemoryState::Private);
+    process->vm_manager.MapMemoryBlock(base + 2 * Memory::PAGE_SIZE, block_b, 0,
+                                       2 * Memory::PAGE_SIZE, Kernel::MemoryState::Private);
+
+    std::vector<Memory::HostRegion> regions;
+
+    SECTION("contiguous pages are merged into one region") {
+        REQUIRE(Memory::GetHostRegions(*process, base + 0x10, 2 * Memory::PAGE_SIZE - 0x20,
+                                       Memory::FlushMode::Flush, regions));
+        REQUIRE(regions.size() == 1);
+        CHECK(regions[0].pointer == block_a->data() + 0x10);
+        CHECK(regions[0].size == 2 * Memory::PAGE_SIZE - 0x20);
+    }
+
+    SECTION("separately backed blocks give one region each") {
+        REQUIRE(Memory::GetHostRegions(*process, base + 0x10, 3 * Memory::PAGE_SIZE,
+                                       Memory::FlushMode::FlushAndInvalidate, regions));
+        REQUIRE(regions.size() == 2);
+        CHECK(regions[0].pointer == block_a->data() + 0x10);
+        CHECK(regions[0].size == 2 * Memory::PAGE_SIZE - 0x10);
+        CHECK(regions[1].pointer == block_b->data());
+        CHECK(regions[1].size == Memory::PAGE_SIZE + 0x10);
+    }
+
+    SECTION("unmapped pages can't be accessed directly") {
+        CHECK_FALSE(Memory::GetHostRegions(*process, base + 3 * Memory::PAGE_SIZE,
+                                           2 * Memory::PAGE_SIZE, Memory::FlushMode::Flush,
+                                           regions));
+    }
+}
+
+TEST_CASE("Memory block transfer benchmark", "[.][benchmark]") {
+    auto process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+
+    // Two 4 MiB blocks, so that the copies stay within one backing block on each side
+    constexpr u32 block_size = 4 * 1024 * 1024;
+    auto block_a = std::make_shared<std::vector<u8>>(block_size, 0x11);
+    auto block_b = std::make_shared<std::vector<u8>>(block_size, 0x22);
+    const VAddr base_a = Memory::HEAP_VADDR;
+    const VAddr base_b = Memory::HEAP_VADDR + block_size;
+    process->vm_manager.MapMemoryBlock(base_a, block_a, 0, block_size,
+                                       Kernel::MemoryState::Private);
+    process->vm_manager.MapMemoryBlock(base_b, block_b, 0, block_size,
+                                       Kernel::MemoryState::Private);
+
+    std::vector<u8> buffer(block_size);
+    for (u32 size : {0x1000u, 0x10000u, 0x100000u, block_size - 0x1000}) {
+        const int iterations = static_cast<int>(256 * 1024 * 1024 / size);
+
+        auto time = [&](const char* name, auto&& transfer) {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                transfer();
+            }
+            const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            std::printf("%s of 0x%x bytes: %.2f GB/s\n", name, size,
+                        static_cast<double>(size) * iterations / elapsed.count() / 1e9);
+        };
+
+        // Offset by 0x10 so that every transfer straddles page boundaries
+        time("ReadBlock", [&] { Memory::ReadBlock(*process, base_a + 0x10, buffer.data(), size); });
+        time("WriteBlock",
+             [&] { Memory::WriteBlock(*process, base_a + 0x10, buffer.data(), size); });
+        time("CopyBlock", [&] { Memory::CopyBlock(*process, base_b + 0x10, base_a + 0x10, size); });
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <memory>
+#include <catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_x64.h"
+
+namespace Pica {
+namespace Shader {
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+static std::unique_ptr<ShaderSetup> MakeShaderSetup(
+    std::initializer_list<nihstro::InlineAsm> code) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    auto setup = std::make_unique<ShaderSetup>();
+    std::memset(setup.get(), 0, sizeof(ShaderSetup));
+    for (unsigned i = 0; i < shbin.program.size(); ++i) {
+        setup->WriteProgramCode(i, shbin.program[i].hex);
+    }
+    for (unsigned i = 0; i < shbin.swizzle_table.size(); ++i) {
+        setup->WriteSwizzleData(i, shbin.swizzle_table[i].hex);
+    }
+    return setup;
+}
+
+static std::unique_ptr<ShaderSetup> MakeTestShader() {
+    const auto v0 = SourceRegister::MakeInput(0);
+    const auto v1 = SourceRegister::MakeInput(1);
+    return MakeShaderSetup({
+        // clang-format off
+        {OpCode::Id::MUL, DestRegister::MakeOutput(0), v0, v1},
+        {OpCode::Id::ADD, DestRegister::MakeOutput(1), v0, v1},
+        {OpCode::Id::MOV, DestRegister::MakeOutput(2), v1},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+}
+
+TEST_CASE("JitX64Engine only rehashes modified programs", "[video_core][shader]") {
+    auto setup = MakeTestShader();
+    JitX64Engine engine;
+
+    engine.SetupBatch(*setup, 0);
+    engine.SetupBatch(*setup, 0);
+    EngineStats stats = engine.GetAndResetStats();
+    CHECK(stats.lookups == 2);
+    CHECK(stats.rehashes == 1);
+    CHECK(stats.compiles == 1);
+
+    // Uploading the same program again doesn't modify it
+    setup->WriteProgramCode(0, setup->program_code[0]);
+    engine.SetupBatch(*setup, 0);
+    stats = engine.GetAndResetStats();
+    CHECK(stats.rehashes == 0);
+
+    const u32 first_word = setup->program_code[0];
+    setup->WriteProgramCode(0, setup->program_code[2]);
+    engine.SetupBatch(*setup, 0);
+    setup->WriteProgramCode(0, first_word);
+    engine.SetupBatch(*setup, 0);
+    stats = engine.GetAndResetStats();
+    CHECK(stats.lookups == 2);
+    CHECK(stats.rehashes == 2);
+    CHECK(stats.compiles == 1);
+}
+
+} // namespace Shader
+} // namespace Pica
@@ -0,0 +1,199 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica_state.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/video_core.h"
+
+namespace Pica {
+
+using Format = PipelineRegs::VertexAttributeFormat;
+
+constexpr unsigned NUM_ATTRIBUTES = 10;
+constexpr unsigned NUM_VERTICES = 1000;
+
+/**
+ * Sets up two loaders with every attribute format, with both full and partial attributes, followed
+ * by a default attribute and an attribute that is neither loaded nor default.
+ */
+static PipelineRegs MakeAttributeConfig() {
+    PipelineRegs regs;
+    std::memset(&regs, 0, sizeof(regs));
+    auto& attributes = regs.vertex_attributes;
+    attributes.base_address.Assign(Memory::VRAM_PADDR / 16);
+
+    attributes.format0.Assign(Format::BYTE);
+    attributes.size0.Assign(3);
+    attributes.format1.Assign(Format::UBYTE);
+    attributes.size1.Assign(3);
+    attributes.format2.Assign(Format::SHORT);
+    attributes.size2.Assign(3);
+    attributes.format3.Assign(Format::FLOAT);
+    attributes.size3.Assign(3);
+    auto& loader0 = attributes.attribute_loaders[0];
+    loader0.comp0.Assign(0);
+    loader0.comp1.Assign(1);
+    loader0.comp2.Assign(2);
+    loader0.comp3.Assign(3);
+    loader0.component_count.Assign(4);
+    loader0.byte_count.Assign(4 + 4 + 8 + 16);
+
+    attributes.format4.Assign(Format::BYTE);
+    attributes.size4.Assign(2);
+    attributes.format5.Assign(Format::UBYTE);
+    attributes.size5.Assign(0);
+    attributes.format6.Assign(Format::SHORT);
+    attributes.size6.Assign(2);
+    attributes.format7.Assign(Format::FLOAT);
+    attributes.size7.Assign(1);
+    auto& loader1 = attributes.attribute_loaders[1];
+    loader1.data_offset.Assign(0x10000);
+    loader1.comp0.Assign(4);
+    loader1.comp1.Assign(5);
+    loader1.comp2.Assign(6);
+    loader1.comp3.Assign(7);
+    loader1.component_count.Assign(4);
+    loader1.byte_count.Assign(20);
+
+    attributes.attribute_mask.Assign(1 << 8);
+    attributes.max_attribute_index.Assign(NUM_ATTRIBUTES - 1);
+    return regs;
+}
+
+/// Sets up a loader with one attribute of each format, all with the given number of elements
+static PipelineRegs MakeUniformAttributeConfig(unsigned num_elements) {
+    PipelineRegs regs;
+    std::memset(&regs, 0, sizeof(regs));
+    auto& attributes = regs.vertex_attributes;
+    attributes.base_address.Assign(Memory::VRAM_PADDR / 16);
+
+    attributes.format0.Assign(Format::BYTE);
+    attributes.size0.Assign(num_elements - 1);
+    attributes.format1.Assign(Format::UBYTE);
+    attributes.size1.Assign(num_elements - 1);
+    attributes.format2.Assign(Format::SHORT);
+    attributes.size2.Assign(num_elements - 1);
+    attributes.format3.Assign(Format::FLOAT);
+    attributes.size3.Assign(num_elements - 1);
+    auto& loader = attributes.attribute_loaders[0];
+    loader.comp0.Assign(0);
+    loader.comp1.Assign(1);
+    loader.comp2.Assign(2);
+    loader.comp3.Assign(3);
+    loader.component_count.Assign(4);
+    // The elements are naturally aligned, which needs no padding in this order
+    loader.byte_count.Assign(num_elements * (1 + 1 + 2 + 4));
+
+    attributes.max_attribute_index.Assign(3);
+    return regs;
+}
+
+static void FillVertexData() {
+    std::mt19937 random(0);
+    u8* data = Memory::GetPhysicalPointer(Memory::VRAM_PADDR);
+    std::generate(data, data + 0x20000, [&] { return static_cast<u8>(random()); });
+
+    for (unsigned i = 0; i < 16; ++i) {
+        for (unsigned comp = 0; comp < 4; ++comp) {
+            g_state.input_default_attributes.attr[i][comp] =
+                float24::FromFloat32(static_cast<float>(i * 4 + comp));
+        }
+    }
+}
+
+static std::vector<Shader::AttributeBuffer> LoadVertices(const PipelineRegs& regs, bool use_jit) {
+    VideoCore::g_shader_jit_enabled = use_jit;
+    VideoCore::g_vertex_loader_jit_enabled = use_jit;
+    VertexLoader loader(regs);
+    DebugUtils::MemoryAccessTracker memory_accesses;
+
+    std::vector<Shader::AttributeBuffer> inputs(NUM_VERTICES);
+    for (unsigned vertex = 0; vertex < NUM_VERTICES; ++vertex) {
+        // Attributes that are neither loaded nor default keep their previous values
+        std::memset(&inputs[vertex], 0xAB, sizeof(inputs[vertex]));
+        loader.LoadVertex(regs.vertex_attributes.GetPhysicalBaseAddress(), vertex, vertex,
+                          inputs[vertex], memory_accesses);
+    }
+    return inputs;
+}
+
+TEST_CASE("VertexLoaderJit matches the interpreted loader", "[video_core]") {
+    const bool jit_enabled = VideoCore::g_shader_jit_enabled;
+    const bool loader_jit_enabled = VideoCore::g_vertex_loader_jit_enabled;
+    const PipelineRegs regs = MakeAttributeConfig();
+    FillVertexData();
+
+    const auto expected = LoadVertices(regs, false);
+    const auto inputs = LoadVertices(regs, true);
+    VideoCore::g_shader_jit_enabled = jit_enabled;
+    VideoCore::g_vertex_loader_jit_enabled = loader_jit_enabled;
+
+    for (unsigned vertex = 0; vertex < NUM_VERTICES; ++vertex) {
+        INFO("vertex " << vertex);
+        for (unsigned i = 0; i < NUM_ATTRIBUTES; ++i) {
+            INFO("attribute " << i);
+            REQUIRE(std::memcmp(&inputs[vertex].attr[i], &expected[vertex].attr[i],
+                                sizeof(inputs[vertex].attr[i])) == 0);
+        }
+    }
+    REQUIRE(inputs[0].attr[8][1].ToFloat32() == 33.f);
+}
+
+TEST_CASE("VertexLoaderJit matches for every format and element count", "[video_core]") {
+    const bool jit_enabled = VideoCore::g_shader_jit_enabled;
+    const bool loader_jit_enabled = VideoCore::g_vertex_loader_jit_enabled;
+    FillVertexData();
+
+    for (unsigned num_elements = 1; num_elements <= 4; ++num_elements) {
+        INFO("elements " << num_elements);
+        const PipelineRegs regs = MakeUniformAttributeConfig(num_elements);
+        const auto expected = LoadVertices(regs, false);
+        const auto inputs = LoadVertices(regs, true);
+
+        for (unsigned vertex = 0; vertex < NUM_VERTICES; ++vertex) {
+            INFO("vertex " << vertex);
+            for (unsigned i = 0; i < 4; ++i) {
+                INFO("attribute " << i);
+                REQUIRE(std::memcmp(&inputs[vertex].attr[i], &expected[vertex].attr[i],
+                                    sizeof(inputs[vertex].attr[i])) == 0);
+            }
+        }
+    }
+    VideoCore::g_shader_jit_enabled = jit_enabled;
+    VideoCore::g_vertex_loader_jit_enabled = loader_jit_enabled;
+}
+
+TEST_CASE("VertexLoaderJit benchmark", "[.][benchmark]") {
+    const bool jit_enabled = VideoCore::g_shader_jit_enabled;
+    const bool loader_jit_enabled = VideoCore::g_vertex_loader_jit_enabled;
+    const PipelineRegs regs = MakeAttributeConfig();
+    FillVertexData();
+
+    for (bool use_jit : {false, true}) {
+        constexpr int iterations = 200;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            LoadVertices(regs, use_jit);
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::printf("%s: %.1f ns per vertex\n", use_jit ? "JIT" : "interpreter",
+                    elapsed.count() / (iterations * NUM_VERTICES));
+    }
+    VideoCore::g_shader_jit_enabled = jit_enabled;
+    VideoCore::g_vertex_loader_jit_enabled = loader_jit_enabled;
+}
+
+} // namespace Pica
@@ -0,0 +1,166 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/regs.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_processor.h"
+
+namespace Pica {
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+constexpr unsigned NUM_OUTPUTS = 4;
+
+/// A synthetic indexed draw, with two float attributes per vertex stored in VRAM
+struct SyntheticDraw {
+    SyntheticDraw(unsigned num_vertices, unsigned num_indices) : indices(num_indices) {
+        std::memset(&regs, 0, sizeof(regs));
+        auto& attributes = regs.pipeline.vertex_attributes;
+        attributes.base_address.Assign(Memory::VRAM_PADDR / 16);
+        attributes.format0.Assign(PipelineRegs::VertexAttributeFormat::FLOAT);
+        attributes.size0.Assign(3);
+        attributes.format1.Assign(PipelineRegs::VertexAttributeFormat::FLOAT);
+        attributes.size1.Assign(3);
+        attributes.max_attribute_index.Assign(1);
+        attributes.attribute_loaders[0].comp0.Assign(0);
+        attributes.attribute_loaders[0].comp1.Assign(1);
+        attributes.attribute_loaders[0].byte_count.Assign(2 * 4 * sizeof(float));
+        attributes.attribute_loaders[0].component_count.Assign(2);
+
+        regs.vs.max_input_attribute_index.Assign(1);
+        regs.vs.input_attribute_to_register_map_low = 0x10;
+        regs.vs.output_mask.Assign((1 << NUM_OUTPUTS) - 1);
+
+        std::mt19937 random(0);
+        float* vertex_data =
+            reinterpret_cast<float*>(Memory::GetPhysicalPointer(Memory::VRAM_PADDR));
+        std::generate(vertex_data, vertex_data + num_vertices * 8, [&] {
+            return std::uniform_real_distribution<float>(-100.f, 100.f)(random);
+        });
+        std::generate(indices.begin(), indices.end(), [&] {
+            return static_cast<u16>(random() % num_vertices);
+        });
+
+        const auto v0 = SourceRegister::MakeInput(0);
+        const auto v1 = SourceRegister::MakeInput(1);
+        const auto shbin = nihstro::InlineAsm::CompileToRawBinary({
+            // clang-format off
+            {OpCode::Id::MOV, DestRegister::MakeOutput(0), v0},
+            {OpCode::Id::MOV, DestRegister::MakeOutput(1), v1},
+            {OpCode::Id::EX2, DestRegister::MakeOutput(2), v0},
+            {OpCode::Id::LG2, DestRegister::MakeOutput(3), v1},
+            {OpCode::Id::END},
+            // clang-format on
+        });
+        setup = std::make_unique<Shader::ShaderSetup>();
+        std::memset(setup.get(), 0, sizeof(Shader::ShaderSetup));
+        for (unsigned i = 0; i < shbin.program.size(); ++i) {
+            setup->WriteProgramCode(i, shbin.program[i].hex);
+        }
+        for (unsigned i = 0; i < shbin.swizzle_table.size(); ++i) {
+            setup->WriteSwizzleData(i, shbin.swizzle_table[i].hex);
+        }
+        engine.SetupBatch(*setup, 0);
+    }
+
+    void Process(VertexProcessor& processor, std::vector<Shader::AttributeBuffer>& outputs) {
+        processor.ProcessVertices(regs, engine, *setup, static_cast<unsigned>(indices.size()),
+                                  [this](unsigned index) { return indices[index]; }, outputs);
+    }
+
+    Regs regs;
+    std::vector<u16> indices;
+    std::unique_ptr<Shader::ShaderSetup> setup;
+    Shader::InterpreterEngine engine;
+};
+
+TEST_CASE("VertexProcessor matches serial processing", "[video_core]") {
+    SyntheticDraw draw(1000, 3000);
+
+    std::vector<Shader::AttributeBuffer> expected(draw.indices.size());
+    VertexLoader loader(draw.regs.pipeline);
+    DebugUtils::MemoryAccessTracker memory_accesses;
+    Shader::UnitState shader_unit;
+    for (unsigned index = 0; index < draw.indices.size(); ++index) {
+        Shader::AttributeBuffer input;
+        loader.LoadVertex(draw.regs.pipeline.vertex_attributes.GetPhysicalBaseAddress(), index,
+                          draw.indices[index], input, memory_accesses);
+        shader_unit.LoadInput(draw.regs.vs, input);
+        draw.engine.Run(*draw.setup, shader_unit);
+        shader_unit.WriteOutput(draw.regs.vs, expected[index]);
+    }
+
+    for (unsigned num_threads : {1, 2, 4}) {
+        INFO(num_threads << " threads");
+        VertexProcessor processor(num_threads);
+        std::vector<Shader::AttributeBuffer> outputs;
+        draw.Process(processor, outputs);
+
+        REQUIRE(outputs.size() == expected.size());
+        for (size_t index = 0; index < outputs.size(); ++index) {
+            INFO("index " << index);
+            REQUIRE(std::memcmp(&outputs[index], &expected[index],
+                                NUM_OUTPUTS * sizeof(outputs[index].attr[0])) == 0);
+        }
+    }
+}
+
+TEST_CASE("VertexProcessor benchmark", "[.][benchmark]") {
+    // The smallest draw that is processed faster on several threads than on one is where
+    // parallel_vertex_threshold should be set on this machine
+    const unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    unsigned threshold = 0;
+    for (unsigned num_indices : {96u, 384u, 1536u, 6144u, 24576u, 98304u}) {
+        SyntheticDraw draw(num_indices / 3, num_indices);
+        std::vector<Shader::AttributeBuffer> outputs;
+        const int draws = std::max(2000000 / static_cast<int>(num_indices), 10);
+
+        double single_thread_time = 0;
+        double best_time = 0;
+        std::printf("%6u indices:", num_indices);
+        for (unsigned num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+            VertexProcessor processor(num_threads);
+            // Leave the start up of the worker threads out of the measurement
+            draw.Process(processor, outputs);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < draws; ++i) {
+                draw.Process(processor, outputs);
+            }
+            const std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+            const double time = elapsed.count() / draws;
+            std::printf("  %u threads %.1f us", num_threads, time);
+
+            if (num_threads == 1) {
+                single_thread_time = time;
+            } else if (best_time == 0 || time < best_time) {
+                best_time = time;
+            }
+        }
+        std::printf("\n");
+
+        if (threshold == 0 && best_time != 0 && best_time < single_thread_time)
+            threshold = num_indices;
+    }
+    std::printf("parallel_vertex_threshold: %u\n", threshold);
+}
+
+} // namespace Pica
@@ -2,10 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -26,6 +30,7 @@
 #include "video_core/renderer_base.h"
 #include "video_core/shader/shader.h"
 #include "video_core/vertex_loader.h"
+#include "video_core/vertex_processor.h"
 #include "video_core/video_core.h"
 
 namespace Pica {
@@ -49,6 +54,85 @@ static const u32 expand_bits_to_bytes[] = {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+// Upper bound for the number of threads that large draws are processed on
+constexpr unsigned int MAX_VERTEX_THREADS = 8;
+static std::unique_ptr<VertexProcessor> vertex_processor;
+// Shaded vertices of the last draw that was processed in parallel, kept to reuse the allocation
+static std::vector<Shader::AttributeBuffer> parallel_vs_outputs;
+
+/// Whether the debugger needs to see the vertices of draw calls one by one
+static bool IsDebuggingVertices() {
+    return g_debug_context &&
+           (g_debug_context->recorder ||
+            g_debug_context->breakpoints[(int)DebugContext::Event::VertexShaderInvocation].enabled);
+}
+
+/// State besides the vertex data that the vertex shader outputs depend on
+struct VertexCacheState {
+    std::array<u32, sizeof(PipelineRegs::vertex_attributes) / sizeof(u32)> vertex_attributes;
+    Shader::AttributeBuffer default_attributes;
+    decltype(Shader::ShaderSetup::uniforms) uniforms;
+    u64 program_generation;
+    u32 main_offset;
+    u32 max_input_attribute_index;
+    u32 input_attribute_to_register_map_low;
+    u32 input_attribute_to_register_map_high;
+    u32 output_mask;
+};
+
+// Bounds for the number of entries of the vertex cache
+constexpr u32 MIN_VERTEX_CACHE_SIZE = 32;
+constexpr u32 MAX_VERTEX_CACHE_SIZE = 0x10000;
+
+// Post-transform cache for the vertices of indexed draws, direct-mapped by vertex index. Each entry
+// is tagged with the generation it was shaded in. The generation only changes when the vertex
+// shader could produce different outputs, so consecutive draws over the same buffers reuse each
+// other's vertices.
+static std::vector<Shader::AttributeBuffer> vertex_cache;
+static std::vector<u32> vertex_cache_ids;
+static std::vector<u64> vertex_cache_generations;
+static u64 vertex_cache_generation = 0;
+static VertexCacheState vertex_cache_state;
+// Set when memory may have been modified since the last draw, e.g. by the CPU
+static bool vertex_memory_modified = true;
+
+/// Resizes the vertex cache to the configured size, and starts a new generation if necessary
+static void SetupVertexCache(const Regs& regs) {
+    u32 size = MIN_VERTEX_CACHE_SIZE;
+    while (size < std::min<u32>(VideoCore::g_vertex_cache_size, MAX_VERTEX_CACHE_SIZE))
+        size *= 2;
+
+    if (vertex_cache.size() != size) {
+        vertex_cache.resize(size);
+        vertex_cache_ids.assign(size, 0);
+        vertex_cache_generations.assign(size, 0);
+        vertex_memory_modified = true;
+    }
+
+    VertexCacheState state;
+    std::memset(&state, 0, sizeof(state));
+    std::memcpy(state.vertex_attributes.data(), &regs.pipeline.vertex_attributes,
+                sizeof(state.vertex_attributes));
+    state.default_attributes = g_state.input_default_attributes;
+    state.uniforms = g_state.vs.uniforms;
+    state.program_generation = g_state.vs.program_generation;
+    state.main_offset = regs.vs.main_offset;
+    state.max_input_attribute_index = regs.vs.max_input_attribute_index;
+    state.input_attribute_to_register_map_low = regs.vs.input_attribute_to_register_map_low;
+    state.input_attribute_to_register_map_high = regs.vs.input_attribute_to_register_map_high;
+    state.output_mask = regs.vs.output_mask;
+
+    // Vertices are not reused across draws while debugging, since the debugger expects to see the
+    // vertices of each draw
+    if (vertex_memory_modified || IsDebuggingVertices() ||
+        std::memcmp(&state, &vertex_cache_state, sizeof(state)) != 0) {
+        // Generation 0 marks the entries that were never written
+        vertex_cache_generation++;
+        vertex_cache_state = state;
+        vertex_memory_modified = false;
+    }
+}
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
         return "vertex shader";
@@ -319,19 +403,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const size_t VERTEX_CACHE_SIZE = 32;
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
-        vertex_cache_ids.fill(-1);
-
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
-
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
         g_state.geometry_pipeline.Reconfigure();
@@ -339,40 +411,77 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+        auto get_vertex = [&](unsigned int index) -> unsigned int {
             // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+            return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                              : (index + regs.pipeline.vertex_offset);
+        };
+
+        // Large draws are loaded and shaded on several threads, unless the vertices have to go
+        // one by one to the debugger or the geometry shader needs their indices
+        const u32 parallel_threshold = VideoCore::g_parallel_vertex_threshold;
+        bool process_in_parallel = parallel_threshold != 0 &&
+                                   regs.pipeline.num_vertices >= parallel_threshold &&
+                                   !g_state.geometry_pipeline.NeedIndexInput() &&
+                                   !IsDebuggingVertices();
+        if (process_in_parallel && vertex_processor == nullptr) {
+            const unsigned int num_threads =
+                std::min(std::thread::hardware_concurrency(), MAX_VERTEX_THREADS);
+            vertex_processor = std::make_unique<VertexProcessor>(std::max(num_threads, 1u));
+        }
+        process_in_parallel = process_in_parallel && vertex_processor->GetNumThreads() > 1;
 
-            // -1 is a common special value used for primitive restart. Since it's unknown if
-            // the PICA supports it, and it would mess up the caching, guard against it here.
-            ASSERT(vertex != -1);
+        if (process_in_parallel) {
+            vertex_processor->ProcessVertices(regs, *shader_engine, g_state.vs,
+                                              regs.pipeline.num_vertices, get_vertex,
+                                              parallel_vs_outputs);
 
-            bool vertex_cache_hit = false;
+            // Send to geometry pipeline
+            for (const Shader::AttributeBuffer& vs_output : parallel_vs_outputs) {
+                g_state.geometry_pipeline.SubmitVertex(vs_output);
+            }
+        } else {
+            Shader::UnitState shader_unit;
 
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
-                }
+            const bool use_vertex_cache =
+                is_indexed && !g_state.geometry_pipeline.NeedIndexInput();
+            if (use_vertex_cache) {
+                SetupVertexCache(regs);
+            }
+            const u32 vertex_cache_mask = static_cast<u32>(vertex_cache.size()) - 1;
+            int vertex_cache_hits = 0;
+            int vertex_cache_misses = 0;
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+            Shader::AttributeBuffer vs_output;
+
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                unsigned int vertex = get_vertex(index);
+
+                // -1 is a common special value used for primitive restart. Since it's unknown if
+                // the PICA supports it, and it would mess up the caching, guard against it here.
+                ASSERT(vertex != -1);
+
+                if (is_indexed) {
+                    if (g_state.geometry_pipeline.NeedIndexInput()) {
+                        g_state.geometry_pipeline.SubmitIndex(vertex);
+                        continue;
+                    }
+
+                    if (g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index,
+                                                  size);
+                    }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
+                    const unsigned int cache_pos = vertex & vertex_cache_mask;
+                    if (vertex_cache_ids[cache_pos] == vertex &&
+                        vertex_cache_generations[cache_pos] == vertex_cache_generation) {
+                        vertex_cache_hits++;
+                        g_state.geometry_pipeline.SubmitVertex(vertex_cache[cache_pos]);
+                        continue;
                     }
                 }
-            }
 
-            if (!vertex_cache_hit) {
                 // Initialize data for the current vertex
                 Shader::AttributeBuffer input;
                 loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
@@ -385,15 +494,22 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 shader_engine->Run(g_state.vs, shader_unit);
                 shader_unit.WriteOutput(regs.vs, vs_output);
 
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                if (use_vertex_cache) {
+                    const unsigned int cache_pos = vertex & vertex_cache_mask;
+                    vertex_cache[cache_pos] = vs_output;
+                    vertex_cache_ids[cache_pos] = vertex;
+                    vertex_cache_generations[cache_pos] = vertex_cache_generation;
+                    vertex_cache_misses++;
                 }
+
+                // Send to geometry pipeline
+                g_state.geometry_pipeline.SubmitVertex(vs_output);
             }
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+            if (use_vertex_cache) {
+                MICROPROFILE_META_CPU("Vertex cache hits", vertex_cache_hits);
+                MICROPROFILE_META_CPU("Vertex cache misses", vertex_cache_misses);
+            }
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -449,7 +565,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (offset >= 4096) {
             LOG_ERROR(HW_GPU, "Invalid GS program offset %u", offset);
         } else {
-            g_state.gs.program_code[offset] = value;
+            g_state.gs.WriteProgramCode(offset, value);
             offset++;
         }
         break;
@@ -467,7 +583,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (offset >= g_state.gs.swizzle_data.size()) {
             LOG_ERROR(HW_GPU, "Invalid GS swizzle pattern offset %u", offset);
         } else {
-            g_state.gs.swizzle_data[offset] = value;
+            g_state.gs.WriteSwizzleData(offset, value);
             offset++;
         }
         break;
@@ -516,9 +632,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (offset >= 512) {
             LOG_ERROR(HW_GPU, "Invalid VS program offset %u", offset);
         } else {
-            g_state.vs.program_code[offset] = value;
+            g_state.vs.WriteProgramCode(offset, value);
             if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
-                g_state.gs.program_code[offset] = value;
+                g_state.gs.WriteProgramCode(offset, value);
             }
             offset++;
         }
@@ -537,9 +653,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (offset >= g_state.vs.swizzle_data.size()) {
             LOG_ERROR(HW_GPU, "Invalid VS swizzle pattern offset %u", offset);
         } else {
-            g_state.vs.swizzle_data[offset] = value;
+            g_state.vs.WriteSwizzleData(offset, value);
             if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
-                g_state.gs.swizzle_data[offset] = value;
+                g_state.gs.WriteSwizzleData(offset, value);
             }
             offset++;
         }
@@ -618,7 +734,20 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                                  reinterpret_cast<void*>(&id));
 }
 
+void Shutdown() {
+    vertex_processor = nullptr;
+
+    vertex_cache.clear();
+    vertex_cache_ids.clear();
+    vertex_cache_generations.clear();
+    vertex_memory_modified = true;
+}
+
 void ProcessCommandList(const u32* list, u32 size) {
+    // The CPU and the other GPU engines only run between command lists, so vertex data can only
+    // have been modified since the last draw if this is a new one
+    vertex_memory_modified = true;
+
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
 
@@ -36,6 +36,9 @@ static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect
 
 void ProcessCommandList(const u32* list, u32 size);
 
+/// Stops the threads used to process the vertices of large draw calls
+void Shutdown();
+
 } // namespace
 
 } // namespace
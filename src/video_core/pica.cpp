@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include "video_core/command_processor.h"
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -18,6 +19,7 @@ void Init() {
 }
 
 void Shutdown() {
+    CommandProcessor::Shutdown();
     Shader::Shutdown();
 }
 
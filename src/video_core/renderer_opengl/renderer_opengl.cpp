@@ -22,6 +22,7 @@
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/shader/shader.h"
 #include "video_core/video_core.h"
 
 static const char vertex_shader[] = R"(
@@ -141,6 +142,10 @@ void RendererOpenGL::SwapBuffers() {
 
     Core::System::GetInstance().perf_stats.EndSystemFrame();
 
+    const Pica::Shader::EngineStats shader_stats = Pica::Shader::GetAndResetEngineStats();
+    LOG_DEBUG(HW_GPU, "Shader lookups: %u, rehashes: %u, compiles: %u", shader_stats.lookups,
+              shader_stats.rehashes, shader_stats.compiles);
+
     // Swap buffers
     render_window->PollEvents();
     render_window->SwapBuffers();
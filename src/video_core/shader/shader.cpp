@@ -161,6 +161,16 @@ void Shutdown() {
 #endif // ARCHITECTURE_x86_64
 }
 
+EngineStats GetAndResetEngineStats() {
+#ifdef ARCHITECTURE_x86_64
+    if (jit_engine != nullptr) {
+        return jit_engine->GetAndResetStats();
+    }
+#endif // ARCHITECTURE_x86_64
+
+    return {};
+}
+
 } // namespace Shader
 
 } // namespace Pica
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <functional>
@@ -198,14 +199,49 @@ struct ShaderSetup {
     std::array<u32, MAX_PROGRAM_CODE_LENGTH> program_code;
     std::array<u32, MAX_SWIZZLE_DATA_LENGTH> swizzle_data;
 
+    /// Incremented whenever a word of program_code or swizzle_data changes
+    u64 program_generation = 0;
+    /// Number of words of program_code that were ever written, the ones past them are all zero
+    unsigned program_code_length = 0;
+    /// Number of words of swizzle_data that were ever written, the ones past them are all zero
+    unsigned swizzle_data_length = 0;
+
+    void WriteProgramCode(unsigned offset, u32 value) {
+        if (program_code[offset] == value)
+            return;
+        program_code[offset] = value;
+        program_code_length = std::max(program_code_length, offset + 1);
+        program_generation++;
+    }
+
+    void WriteSwizzleData(unsigned offset, u32 value) {
+        if (swizzle_data[offset] == value)
+            return;
+        swizzle_data[offset] = value;
+        swizzle_data_length = std::max(swizzle_data_length, offset + 1);
+        program_generation++;
+    }
+
     /// Data private to ShaderEngines
     struct EngineData {
         unsigned int entry_point;
         /// Used by the JIT, points to a compiled shader object.
         const void* cached_shader = nullptr;
+        /// Used by the JIT, program_generation at the time cached_shader was looked up.
+        u64 cached_program_generation = 0;
     } engine_data;
 };
 
+/// Statistics of the shader engine, which are reset every frame
+struct EngineStats {
+    /// Number of compiled shaders looked up by SetupBatch
+    u32 lookups = 0;
+    /// Number of lookups that had to hash the program, because it changed since the last one
+    u32 rehashes = 0;
+    /// Number of lookups that had to compile the program
+    u32 compiles = 0;
+};
+
 class ShaderEngine {
 public:
     virtual ~ShaderEngine() = default;
@@ -229,6 +265,9 @@ public:
 ShaderEngine* GetEngine();
 void Shutdown();
 
+/// Gets the statistics of the shader engine since the last call, and resets them
+EngineStats GetAndResetEngineStats();
+
 } // namespace Shader
 
 } // namespace Pica
@@ -17,20 +17,40 @@ JitX64Engine::~JitX64Engine() = default;
 void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
+    stats.lookups++;
 
-    u64 code_hash = Common::ComputeHash64(&setup.program_code, sizeof(setup.program_code));
-    u64 swizzle_hash = Common::ComputeHash64(&setup.swizzle_data, sizeof(setup.swizzle_data));
+    // The compiled shader doesn't depend on the entry point, so it only has to be looked up again
+    // after the program changed
+    if (setup.engine_data.cached_shader != nullptr &&
+        setup.engine_data.cached_program_generation == setup.program_generation) {
+        return;
+    }
+
+    // Words past the used lengths are always zero, so they don't need to be hashed
+    stats.rehashes++;
+    u64 code_hash = Common::ComputeHash64(setup.program_code.data(),
+                                          setup.program_code_length * sizeof(u32));
+    u64 swizzle_hash = Common::ComputeHash64(setup.swizzle_data.data(),
+                                             setup.swizzle_data_length * sizeof(u32));
 
     u64 cache_key = code_hash ^ swizzle_hash;
     auto iter = cache.find(cache_key);
     if (iter != cache.end()) {
         setup.engine_data.cached_shader = iter->second.get();
     } else {
+        stats.compiles++;
         auto shader = std::make_unique<JitShader>();
         shader->Compile(&setup.program_code, &setup.swizzle_data);
         setup.engine_data.cached_shader = shader.get();
         cache.emplace_hint(iter, cache_key, std::move(shader));
     }
+    setup.engine_data.cached_program_generation = setup.program_generation;
+}
+
+EngineStats JitX64Engine::GetAndResetStats() {
+    EngineStats result = stats;
+    stats = {};
+    return result;
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
@@ -22,8 +22,11 @@ public:
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
+    EngineStats GetAndResetStats();
+
 private:
     std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+    EngineStats stats;
 };
 
 } // namespace Shader
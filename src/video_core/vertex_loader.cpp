@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
@@ -13,6 +15,11 @@
 #include "video_core/regs_pipeline.h"
 #include "video_core/shader/shader.h"
 #include "video_core/vertex_loader.h"
+#include "video_core/video_core.h"
+
+#if defined(ARCHITECTURE_x86_64) && defined(ENABLE_VERTEX_LOADER_JIT)
+#include "video_core/vertex_loader_jit_x64.h"
+#endif
 
 namespace Pica {
 
@@ -68,6 +75,64 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
     }
 
     is_setup = true;
+
+#if defined(ARCHITECTURE_x86_64) && defined(ENABLE_VERTEX_LOADER_JIT)
+    // The compiled loaders don't record memory accesses, so they can't be used for CiTraces
+    if (VideoCore::g_shader_jit_enabled && VideoCore::g_vertex_loader_jit_enabled &&
+        !(g_debug_context && g_debug_context->recorder)) {
+        jit_loader = VertexLoaderJit::Get(*this);
+    }
+#endif
+}
+
+void VertexLoader::SetupJitPointers(u32 base_address) {
+    jit_base_address = base_address;
+    jit_pointers_valid = true;
+    jit_num_vertices = std::numeric_limits<u32>::max();
+
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] == 0)
+            continue;
+
+        // The vertex arrays may lie in different memory regions, so the range of vertices that
+        // the compiled loader can access without going past the end of one is checked up front
+        const u32 element_size =
+            (vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
+                ? 4
+                : (vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::SHORT) ? 2
+                                                                                               : 1;
+        const u32 attribute_size = vertex_attribute_elements[i] * element_size;
+
+        u32 contiguous_size;
+        jit_attribute_pointers[i] =
+            Memory::GetPhysicalPointer(base_address + vertex_attribute_sources[i], contiguous_size);
+        if (jit_attribute_pointers[i] == nullptr || contiguous_size < attribute_size) {
+            jit_num_vertices = 0;
+            return;
+        }
+
+        if (vertex_attribute_strides[i] != 0) {
+            jit_num_vertices =
+                std::min(jit_num_vertices,
+                         (contiguous_size - attribute_size) / vertex_attribute_strides[i] + 1);
+        }
+    }
+}
+
+bool VertexLoader::LoadVertexJit(u32 base_address, int vertex, Shader::AttributeBuffer& input) {
+#if defined(ARCHITECTURE_x86_64) && defined(ENABLE_VERTEX_LOADER_JIT)
+    if (!jit_pointers_valid || base_address != jit_base_address) {
+        SetupJitPointers(base_address);
+    }
+    if (static_cast<u32>(vertex) >= jit_num_vertices)
+        return false;
+
+    jit_loader->Load(jit_attribute_pointers.data(), static_cast<u32>(vertex), input,
+                     g_state.input_default_attributes);
+    return true;
+#else
+    return false;
+#endif
 }
 
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
@@ -75,6 +140,9 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               DebugUtils::MemoryAccessTracker& memory_accesses) {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
+    if (jit_loader != nullptr && LoadVertexJit(base_address, vertex, input))
+        return;
+
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
             // Load per-vertex data from the loader arrays
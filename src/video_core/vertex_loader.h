@@ -14,6 +14,8 @@ namespace Shader {
 struct AttributeBuffer;
 }
 
+class VertexLoaderJit;
+
 class VertexLoader {
 public:
     VertexLoader() = default;
@@ -30,6 +32,16 @@ public:
     }
 
 private:
+    friend class VertexLoaderJit;
+
+    /**
+     * Loads a vertex through the compiled loader.
+     * @return false if the vertex data isn't covered by the attribute pointers of the compiled
+     *         loader, in which case the vertex needs to be loaded by the interpreted loader
+     */
+    bool LoadVertexJit(u32 base_address, int vertex, Shader::AttributeBuffer& input);
+    void SetupJitPointers(u32 base_address);
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -37,6 +49,16 @@ private:
     std::array<bool, 16> vertex_attribute_is_default;
     int num_total_attributes = 0;
     bool is_setup = false;
+
+    /// Compiled loader for this attribute configuration, or nullptr if it isn't used
+    const VertexLoaderJit* jit_loader = nullptr;
+    /// Base address that the attribute pointers were computed for
+    u32 jit_base_address = 0;
+    bool jit_pointers_valid = false;
+    /// Host pointer to the data of vertex 0 of each loaded attribute
+    std::array<const u8*, 16> jit_attribute_pointers{};
+    /// Number of vertices, starting at 0, that can be loaded through the attribute pointers
+    u32 jit_num_vertices = 0;
 };
 
 } // namespace Pica
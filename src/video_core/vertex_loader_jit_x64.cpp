@@ -0,0 +1,169 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <xbyak.h>
+#include "common/assert.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/x64/xbyak_abi.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+namespace Pica {
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+
+constexpr size_t MAX_LOADER_SIZE = 8 * 1024;
+
+// Registers used by the compiled loaders. They are all caller-saved, so the loaders don't need to
+// save any registers.
+static const Xbyak::Reg64 ATTRIBUTE_POINTERS = ABI_PARAM1.cvt64();
+static const Xbyak::Reg32 VERTEX = ABI_PARAM2.cvt32();
+static const Xbyak::Reg64 INPUT = ABI_PARAM3.cvt64();
+static const Xbyak::Reg64 DEFAULT_ATTRIBUTES = ABI_PARAM4.cvt64();
+static const Xbyak::Reg64 SOURCE = rax;
+static const Xbyak::Reg32 SCRATCH = r10d;
+static const Xbyak::Xmm VALUE = xmm0;
+static const Xbyak::Xmm ZERO = xmm1;
+
+/// Attribute configuration that the code of a compiled loader depends on
+struct LoaderKey {
+    std::array<u32, 16> strides;
+    std::array<u32, 16> formats;
+    std::array<u32, 16> elements;
+    std::array<u32, 16> is_default;
+    u32 num_total_attributes;
+};
+
+static std::mutex cache_mutex;
+static std::unordered_map<u64, std::unique_ptr<VertexLoaderJit>> cache;
+
+const VertexLoaderJit* VertexLoaderJit::Get(const VertexLoader& loader) {
+    LoaderKey key;
+    std::memset(&key, 0, sizeof(key));
+    key.num_total_attributes = loader.num_total_attributes;
+    for (int i = 0; i < loader.num_total_attributes; ++i) {
+        key.elements[i] = loader.vertex_attribute_elements[i];
+        if (key.elements[i] != 0) {
+            key.strides[i] = loader.vertex_attribute_strides[i];
+            key.formats[i] = static_cast<u32>(loader.vertex_attribute_formats[i]);
+        } else {
+            key.is_default[i] = loader.vertex_attribute_is_default[i];
+        }
+    }
+    const u64 hash = Common::ComputeHash64(&key, sizeof(key));
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto& jit = cache[hash];
+    if (jit == nullptr) {
+        jit = std::make_unique<VertexLoaderJit>(loader);
+    }
+    return jit.get();
+}
+
+VertexLoaderJit::VertexLoaderJit(const VertexLoader& loader)
+    : Xbyak::CodeGenerator(MAX_LOADER_SIZE) {
+    program = (CompiledLoader*)getCurr();
+
+    pxor(ZERO, ZERO);
+    for (int i = 0; i < loader.num_total_attributes; ++i) {
+        Compile_Attribute(loader, i);
+    }
+    ret();
+
+    ready();
+
+    ASSERT_MSG(getSize() <= MAX_LOADER_SIZE,
+               "Compiled a vertex loader that exceeds the allocated size!");
+    LOG_DEBUG(HW_GPU, "Compiled vertex loader size=%lu", getSize());
+}
+
+void VertexLoaderJit::Compile_Attribute(const VertexLoader& loader, int attribute) {
+    const size_t output = attribute * sizeof(Math::Vec4<float24>);
+    const u32 elements = loader.vertex_attribute_elements[attribute];
+
+    if (elements == 0) {
+        if (loader.vertex_attribute_is_default[attribute]) {
+            movaps(VALUE, xword[DEFAULT_ATTRIBUTES + output]);
+            movaps(xword[INPUT + output], VALUE);
+        }
+        // Otherwise, the attribute keeps whatever value it had, like in the interpreted loader
+        return;
+    }
+
+    // SOURCE = attribute_pointers[attribute] + vertex * stride
+    mov(SOURCE, qword[ATTRIBUTE_POINTERS + attribute * sizeof(const u8*)]);
+    imul(SCRATCH, VERTEX, loader.vertex_attribute_strides[attribute]);
+    add(SOURCE, SCRATCH.cvt64());
+
+    const auto format = loader.vertex_attribute_formats[attribute];
+    if (elements == 4) {
+        // Convert all four components at once
+        switch (format) {
+        case PipelineRegs::VertexAttributeFormat::BYTE:
+            movd(VALUE, dword[SOURCE]);
+            punpcklbw(VALUE, VALUE);
+            punpcklwd(VALUE, VALUE);
+            psrad(VALUE, 24);
+            cvtdq2ps(VALUE, VALUE);
+            break;
+        case PipelineRegs::VertexAttributeFormat::UBYTE:
+            movd(VALUE, dword[SOURCE]);
+            punpcklbw(VALUE, ZERO);
+            punpcklwd(VALUE, ZERO);
+            cvtdq2ps(VALUE, VALUE);
+            break;
+        case PipelineRegs::VertexAttributeFormat::SHORT:
+            movq(VALUE, qword[SOURCE]);
+            punpcklwd(VALUE, VALUE);
+            psrad(VALUE, 16);
+            cvtdq2ps(VALUE, VALUE);
+            break;
+        case PipelineRegs::VertexAttributeFormat::FLOAT:
+            movups(VALUE, xword[SOURCE]);
+            break;
+        }
+        movaps(xword[INPUT + output], VALUE);
+        return;
+    }
+
+    // Reading all four components could go past the end of the vertex array, so convert the
+    // components one by one
+    for (u32 comp = 0; comp < elements; ++comp) {
+        switch (format) {
+        case PipelineRegs::VertexAttributeFormat::BYTE:
+            movsx(SCRATCH, byte[SOURCE + comp]);
+            cvtsi2ss(VALUE, SCRATCH);
+            break;
+        case PipelineRegs::VertexAttributeFormat::UBYTE:
+            movzx(SCRATCH, byte[SOURCE + comp]);
+            cvtsi2ss(VALUE, SCRATCH);
+            break;
+        case PipelineRegs::VertexAttributeFormat::SHORT:
+            movsx(SCRATCH, word[SOURCE + comp * 2]);
+            cvtsi2ss(VALUE, SCRATCH);
+            break;
+        case PipelineRegs::VertexAttributeFormat::FLOAT:
+            movss(VALUE, dword[SOURCE + comp * 4]);
+            break;
+        }
+        movss(dword[INPUT + output + comp * 4], VALUE);
+    }
+
+    // Missing components default to (0, 0, 0, 1), see VertexLoader::LoadVertex
+    static_assert(sizeof(float24) == sizeof(float), "float24 must be stored as a float");
+    for (u32 comp = elements; comp < 4; ++comp) {
+        mov(dword[INPUT + output + comp * 4], comp == 3 ? 0x3F800000 : 0);
+    }
+}
+
+} // namespace Pica
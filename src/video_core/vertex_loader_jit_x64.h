@@ -0,0 +1,54 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <xbyak.h>
+#include "common/common_types.h"
+
+namespace Pica {
+
+namespace Shader {
+struct AttributeBuffer;
+}
+
+class VertexLoader;
+
+/**
+ * Vertex loader compiled for one vertex attribute configuration. The attribute strides, formats
+ * and element counts are baked into the code, while the attribute addresses are passed in, so
+ * that draws which only differ in where their vertex arrays are located share the same code.
+ */
+class VertexLoaderJit : public Xbyak::CodeGenerator {
+public:
+    /**
+     * Gets the compiled loader for the attribute configuration of a vertex loader, compiling it
+     * if this configuration hasn't been seen yet. Safe to call from several threads.
+     */
+    static const VertexLoaderJit* Get(const VertexLoader& loader);
+
+    explicit VertexLoaderJit(const VertexLoader& loader);
+
+    /**
+     * Loads the attributes of a vertex.
+     * @param attribute_pointers Host pointer to the data of vertex 0, for each loaded attribute
+     * @param vertex Index of the vertex to load
+     * @param input Receives the attributes
+     * @param default_attributes Values of the attributes that are configured to use them
+     */
+    void Load(const u8* const* attribute_pointers, u32 vertex, Shader::AttributeBuffer& input,
+              const Shader::AttributeBuffer& default_attributes) const {
+        program(attribute_pointers, vertex, &input, &default_attributes);
+    }
+
+private:
+    void Compile_Attribute(const VertexLoader& loader, int attribute);
+
+    using CompiledLoader = void(const u8* const* attribute_pointers, u32 vertex,
+                                Shader::AttributeBuffer* input,
+                                const Shader::AttributeBuffer* default_attributes);
+    CompiledLoader* program = nullptr;
+};
+
+} // namespace Pica
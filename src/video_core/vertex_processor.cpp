@@ -0,0 +1,130 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include "common/thread.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/regs.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_processor.h"
+
+namespace Pica {
+
+// Number of index positions that a thread processes at once
+constexpr unsigned CHUNK_SIZE = 64;
+// Size of the direct-mapped cache a thread uses to shade each vertex of a chunk only once
+constexpr unsigned CHUNK_CACHE_SIZE = 32;
+
+/// Loads and shades the vertices of the index positions [begin, end)
+static void ProcessChunk(const Regs& regs, const Shader::ShaderEngine& engine,
+                         const Shader::ShaderSetup& setup, VertexLoader& loader,
+                         Shader::UnitState& shader_unit, unsigned begin, unsigned end,
+                         const std::function<unsigned(unsigned)>& get_vertex,
+                         Shader::AttributeBuffer* outputs) {
+    const u32 base_address = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress();
+    // Memory accesses are only tracked for the CiTrace recorder, which needs serial processing
+    DebugUtils::MemoryAccessTracker memory_accesses;
+
+    // Vertices shaded in the chunk, and the index position each one was shaded at
+    std::array<unsigned, CHUNK_CACHE_SIZE> cache_vertices;
+    std::array<unsigned, CHUNK_CACHE_SIZE> cache_indices;
+    cache_vertices.fill(-1);
+
+    Shader::AttributeBuffer input;
+    for (unsigned index = begin; index < end; ++index) {
+        const unsigned vertex = get_vertex(index);
+        const unsigned cache_pos = vertex % CHUNK_CACHE_SIZE;
+        if (cache_vertices[cache_pos] == vertex) {
+            outputs[index] = outputs[cache_indices[cache_pos]];
+            continue;
+        }
+
+        loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+        shader_unit.LoadInput(regs.vs, input);
+        engine.Run(setup, shader_unit);
+        shader_unit.WriteOutput(regs.vs, outputs[index]);
+
+        cache_vertices[cache_pos] = vertex;
+        cache_indices[cache_pos] = index;
+    }
+}
+
+VertexProcessor::VertexProcessor(unsigned num_threads) {
+    for (unsigned i = 1; i < num_threads; ++i) {
+        workers.emplace_back(&VertexProcessor::WorkerThread, this);
+    }
+}
+
+VertexProcessor::~VertexProcessor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void VertexProcessor::ProcessVertices(const Regs& regs, const Shader::ShaderEngine& engine,
+                                      const Shader::ShaderSetup& setup, unsigned num_vertices,
+                                      const std::function<unsigned(unsigned)>& get_vertex,
+                                      std::vector<Shader::AttributeBuffer>& outputs) {
+    outputs.resize(num_vertices);
+
+    const unsigned num_chunks = (num_vertices + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::atomic<unsigned> next_chunk{0};
+    RunOnAllThreads([&] {
+        VertexLoader loader(regs.pipeline);
+        Shader::UnitState shader_unit;
+        for (unsigned chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+            const unsigned begin = chunk * CHUNK_SIZE;
+            const unsigned end = std::min(begin + CHUNK_SIZE, num_vertices);
+            ProcessChunk(regs, engine, setup, loader, shader_unit, begin, end, get_vertex,
+                         outputs.data());
+        }
+    });
+}
+
+void VertexProcessor::RunOnAllThreads(const std::function<void()>& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_job = &job;
+        job_generation++;
+        busy_workers = static_cast<unsigned>(workers.size());
+    }
+    work_cv.notify_all();
+
+    job();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    current_job = nullptr;
+}
+
+void VertexProcessor::WorkerThread() {
+    Common::SetCurrentThreadName("VertexProcessor");
+
+    u64 done_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work_cv.wait(lock, [&] { return stop || job_generation != done_generation; });
+        if (stop)
+            return;
+
+        done_generation = job_generation;
+        const std::function<void()>& job = *current_job;
+        lock.unlock();
+        job();
+        lock.lock();
+
+        if (--busy_workers == 0)
+            done_cv.notify_one();
+    }
+}
+
+} // namespace Pica
@@ -0,0 +1,73 @@
+// Copyright 2017 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Pica {
+
+struct Regs;
+
+namespace Shader {
+struct AttributeBuffer;
+class ShaderEngine;
+struct ShaderSetup;
+} // namespace Shader
+
+/**
+ * Loads and shades the vertices of large draw calls on several threads. The index positions of a
+ * draw are handed out to the threads in chunks, and each thread uses its own vertex loader and
+ * shader unit. The shaded vertices are stored in the order of the index positions, so that they
+ * can go through primitive assembly just like the serially processed ones.
+ */
+class VertexProcessor : NonCopyable {
+public:
+    /// @param num_threads Number of threads to process vertices on, including the calling one
+    explicit VertexProcessor(unsigned num_threads);
+    ~VertexProcessor();
+
+    unsigned GetNumThreads() const {
+        return static_cast<unsigned>(workers.size()) + 1;
+    }
+
+    /**
+     * Loads and shades the vertices of a draw call.
+     *
+     * @param regs Pica registers of the draw call
+     * @param engine Shader engine, already set up for the vertex shader
+     * @param setup Vertex shader setup
+     * @param num_vertices Number of index positions of the draw call
+     * @param get_vertex Gets the vertex of an index position, called from all threads
+     * @param outputs Receives the shaded vertex of each index position
+     */
+    void ProcessVertices(const Regs& regs, const Shader::ShaderEngine& engine,
+                         const Shader::ShaderSetup& setup, unsigned num_vertices,
+                         const std::function<unsigned(unsigned)>& get_vertex,
+                         std::vector<Shader::AttributeBuffer>& outputs);
+
+private:
+    /// Runs a job on every thread, and waits for all of them to finish it
+    void RunOnAllThreads(const std::function<void()>& job);
+    void WorkerThread();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    const std::function<void()>* current_job = nullptr;
+    /// Incremented for every job, so that the workers can tell when there's a new one
+    u64 job_generation = 0;
+    /// Number of workers that are still running the current job
+    unsigned busy_workers = 0;
+    bool stop = false;
+};
+
+} // namespace Pica
@@ -19,8 +19,11 @@ std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
+std::atomic<bool> g_vertex_loader_jit_enabled;
 std::atomic<bool> g_vsync_enabled;
 std::atomic<bool> g_toggle_framelimit_enabled;
+std::atomic<u32> g_parallel_vertex_threshold;
+std::atomic<u32> g_vertex_cache_size;
 
 /// Initialize the video core
 bool Init(EmuWindow* emu_window) {
@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <memory>
+#include "common/common_types.h"
 
 class EmuWindow;
 class RendererBase;
@@ -22,7 +23,13 @@ extern EmuWindow* g_emu_window;                  ///< Emu window
 // qt ui)
 extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
+/// Whether vertex attributes are loaded by compiled loaders, which also needs the shader JIT
+extern std::atomic<bool> g_vertex_loader_jit_enabled;
 extern std::atomic<bool> g_toggle_framelimit_enabled;
+/// Minimum number of vertices for a draw call to be processed on several threads, 0 to disable
+extern std::atomic<u32> g_parallel_vertex_threshold;
+/// Number of entries of the post-transform vertex cache, rounded up to a power of two
+extern std::atomic<u32> g_vertex_cache_size;
 
 /// Start the video core
 void Start();